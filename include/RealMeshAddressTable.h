@@ -0,0 +1,79 @@
+#ifndef REALMESH_ADDRESS_TABLE_H
+#define REALMESH_ADDRESS_TABLE_H
+
+#include "RealMeshTypes.h"
+
+// ============================================================================
+// Node Address Intern Table
+// ============================================================================
+//
+// Maps each distinct nodeId@subdomain to a small, stable AddressHandle with
+// its hash and UUID cached. Router tables store handles, so address equality
+// is an integer compare and each name is held in memory exactly once.
+// Unreferenced entries are reclaimed by a mark/sweep pass driven by the owner.
+// A "#<hash>" placeholder is indexed under the hash it carries, so it
+// stands for the node until its name is learned, then takes that name
+// while keeping its handle.
+
+class RealMeshAddressTable {
+public:
+    RealMeshAddressTable();
+    
+    // Find or add an address (RM_INVALID_ADDRESS if the table is full)
+    AddressHandle intern(const NodeAddress& address);
+    
+    // Find an address without adding it
+    AddressHandle lookup(const NodeAddress& address) const;
+    
+    // Find a node by the 16-bit short ID carried in path history
+    AddressHandle findByShortId(uint16_t shortId) const;
+    
+    // Find a node by address hash alone, as carried in v2 frames
+    AddressHandle findByHash(uint32_t hash) const;
+    
+    // Access interned data
+    bool isValid(AddressHandle handle) const;
+    const NodeAddress& get(AddressHandle handle) const;
+    uint32_t hashOf(AddressHandle handle) const;
+    uint16_t shortIdOf(AddressHandle handle) const;   // 0 if UUID not yet known
+    String nameOf(AddressHandle handle) const;
+    
+    // Garbage collection: clear marks, mark live handles, then sweep
+    void beginCollection();
+    void mark(AddressHandle handle);
+    size_t sweep();
+    
+    size_t size() const { return count; }
+    bool isFull() const { return count >= RM_MAX_ADDRESSES; }
+    
+private:
+    static const uint16_t SLOT_EMPTY = 0xFFFF;
+    static const uint16_t SLOT_DELETED = 0xFFFE;
+    
+    struct Slot {
+        uint32_t hash;
+        AddressHandle handle;
+    };
+    
+    struct Entry {
+        NodeAddress address;
+        uint32_t hash;
+        uint32_t lastUsed;
+        bool inUse;
+        bool marked;
+    };
+    
+    Slot slots[RM_ADDRESS_TABLE_SLOTS];
+    Entry entries[RM_MAX_ADDRESSES];
+    uint16_t shortIds[RM_MAX_ADDRESSES];   // Packed for fast path-history scans (0 = unknown)
+    uint16_t count;
+    uint16_t deletedSlots;
+    uint16_t nextFree;
+    
+    int findSlot(uint32_t hash, const NodeAddress& address) const;
+    static bool matches(const NodeAddress& known, const NodeAddress& address);
+    void removeSlot(uint32_t hash, AddressHandle handle);
+    void rebuildIndex();
+};
+
+#endif // REALMESH_ADDRESS_TABLE_H
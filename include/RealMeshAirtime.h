@@ -0,0 +1,70 @@
+#ifndef REALMESH_AIRTIME_H
+#define REALMESH_AIRTIME_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "RealMeshConfig.h"
+
+// ============================================================================
+// LoRa Time-on-Air Model
+// ============================================================================
+//
+// Semtech SX126x formula (datasheet section 6.1.4), usable in constant
+// expressions so budgets and timeouts can be checked at compile time.
+// Coding rate is given as the denominator (5-8 for 4/5-4/8), matching
+// RM_CODING_RATE. Low data rate optimisation is assumed whenever a symbol
+// lasts 16 ms or more, as RadioLib enables it automatically.
+
+class RealMeshAirtime {
+public:
+    // Duration of one symbol in microseconds
+    static constexpr uint32_t symbolTimeUs(uint8_t sf, float bwKhz) {
+        return (uint32_t)((float)(1UL << sf) * 1000.0f / bwKhz);
+    }
+    
+    static constexpr bool lowDataRateOptimize(uint8_t sf, float bwKhz) {
+        return symbolTimeUs(sf, bwKhz) >= 16000;
+    }
+    
+    // Symbols after the preamble, including the 8 fixed header symbols
+    static constexpr uint32_t payloadSymbols(size_t bytes, uint8_t sf, float bwKhz, uint8_t cr,
+                                             bool explicitHeader, bool crc) {
+        return 8 + ceilDiv((int32_t)(8 * bytes) + (crc ? 16 : 0) - 4 * sf +
+                           (sf < 7 ? 0 : 8) + (explicitHeader ? 20 : 0),
+                           4 * (lowDataRateOptimize(sf, bwKhz) ? sf - 2 : sf)) * cr;
+    }
+    
+    // Whole frame on air, in microseconds
+    static constexpr uint32_t timeOnAirUs(size_t bytes,
+                                          uint8_t sf = RM_SPREADING_FACTOR,
+                                          float bwKhz = RM_BANDWIDTH_KHZ,
+                                          uint8_t cr = RM_CODING_RATE,
+                                          uint16_t preamble = RM_PREAMBLE_LENGTH,
+                                          bool explicitHeader = true,
+                                          bool crc = true) {
+        return (uint32_t)((uint64_t)(preambleQuarterSymbols(preamble, sf) +
+                                     4 * payloadSymbols(bytes, sf, bwKhz, cr, explicitHeader, crc)) *
+                          symbolTimeUs(sf, bwKhz) / 4);
+    }
+    
+    // Whole frame on air, rounded up to milliseconds
+    static constexpr uint32_t timeOnAirMs(size_t bytes,
+                                          uint8_t sf = RM_SPREADING_FACTOR,
+                                          float bwKhz = RM_BANDWIDTH_KHZ,
+                                          uint8_t cr = RM_CODING_RATE,
+                                          uint16_t preamble = RM_PREAMBLE_LENGTH) {
+        return (timeOnAirUs(bytes, sf, bwKhz, cr, preamble) + 999) / 1000;
+    }
+    
+private:
+    static constexpr uint32_t ceilDiv(int32_t num, int32_t den) {
+        return num <= 0 ? 0 : (uint32_t)((num + den - 1) / den);
+    }
+    
+    // Preamble plus sync word: n + 4.25 symbols (n + 6.25 at SF5/SF6)
+    static constexpr uint32_t preambleQuarterSymbols(uint16_t preamble, uint8_t sf) {
+        return 4 * (uint32_t)preamble + (sf < 7 ? 25 : 17);
+    }
+};
+
+#endif // REALMESH_AIRTIME_H
@@ -0,0 +1,33 @@
+#ifndef REALMESH_COMPRESSION_H
+#define REALMESH_COMPRESSION_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// ============================================================================
+// Static-Dictionary Text Compression
+// ============================================================================
+//
+// Short-string coder for chat payloads, marked on air by ROUTE_COMPRESSED.
+// Output bytes:
+//   0x00-0x7F  ASCII as is
+//   0x80-0xC5  one Serbian letter: Cyrillic or Latin with diacritics (2 bytes in UTF-8)
+//   0xC6-0xFD  dictionary entry (common Serbian and English fragments)
+//   0xFE b     one raw byte
+//   0xFF n ... n raw bytes (emoji and other UTF-8)
+// The tables are fixed, so every node encodes the same text the same way.
+
+class RealMeshCompression {
+public:
+    // Encode into out; 0 if the result wouldn't be shorter or doesn't fit
+    static size_t compress(const uint8_t* in, size_t length, uint8_t* out, size_t outSize);
+    
+    // Decode into out; 0 if the input is malformed or doesn't fit
+    static size_t decompress(const uint8_t* in, size_t length, uint8_t* out, size_t outSize);
+
+private:
+    static int letterCode(const uint8_t* in, size_t remaining);
+    static size_t dictionaryMatch(const uint8_t* in, size_t remaining, uint8_t& code);
+};
+
+#endif // REALMESH_COMPRESSION_H
@@ -76,33 +76,142 @@
 #define RM_HEADER_SIZE             32
 #define RM_MAX_PAYLOAD_SIZE        (RM_MAX_PACKET_SIZE - RM_HEADER_SIZE)
 #define RM_MAX_HOP_COUNT           10
-#define RM_PATH_HISTORY_SIZE       3
+#define RM_PATH_HISTORY_SIZE       3        // Last relays, 16-bit short IDs
 
 // Timing Configuration (milliseconds)
 #define RM_ACK_TIMEOUT_DIRECT      10000    // 10 seconds
 #define RM_ACK_TIMEOUT_FLOOD       30000    // 30 seconds
 #define RM_RETRY_INTERVAL_BASE     5000     // 5 seconds
 #define RM_RETRY_INTERVAL_MAX      45000    // 45 seconds
-#define RM_HEARTBEAT_STATIONARY    15000    // 15 seconds (was 5 minutes - too slow!)
-#define RM_HEARTBEAT_MOBILE        30000    // 30 seconds (was 15 minutes - too slow!)
+#define RM_RETRY_JITTER_PERCENT    25       // Random spread added to each retry interval
+#define RM_HEARTBEAT_IMIN          3000     // Trickle interval after start-up or a topology change
+#define RM_HEARTBEAT_STATIONARY    120000   // Longest Trickle interval for stationary nodes
+#define RM_HEARTBEAT_MOBILE        240000   // Longest Trickle interval for mobile nodes
+#define RM_HEARTBEAT_REDUNDANCY    2        // Consistent heartbeats heard before we stay quiet
+#define RM_HEARTBEAT_MAX_SILENCE   270000   // Never suppress past this, routes to us would go stale
+#define RM_HEARTBEAT_FULL_EVERY    4        // Every Nth heartbeat carries all fields, not just changes
+#define RM_HEARTBEAT_MAX_NODES     32       // Heartbeat summaries kept for other nodes
 #define RM_MESSAGE_MAX_AGE         600000   // 10 minutes
+#define RM_ROUTE_STALE_MS          300000   // Unrefreshed routes may be replaced after 5 minutes
+#define RM_ROUTE_DISCOVERY_TIMEOUT 8000     // Wait for a route reply before retrying
 #define RM_NAME_CONFLICT_TIMEOUT   259200000 // 72 hours
 #define RM_NETWORK_JOIN_TIMEOUT    30000    // 30 seconds
+#define RM_TX_TIMEOUT_MS           10000    // Abort a transmission that never signals TxDone
+
+// Packet Pool Configuration
+#define RM_PACKET_POOL_SIZE        48       // Packets held at once (~600 B each): queues, retries, relays, discovery buffers
 
 // Queue Configuration
 #define RM_QUEUE_EMERGENCY_SIZE    20
 #define RM_QUEUE_DIRECT_SIZE       10
 #define RM_QUEUE_PUBLIC_SIZE       5
 #define RM_QUEUE_CONTROL_SIZE      15
+#define RM_QUEUE_DIRECT_MAX_AGE    60000    // Direct messages waiting longer are evicted
+#define RM_QUEUE_PUBLIC_MAX_AGE    20000    // Public chatter goes stale fast (shrinks with load)
+#define RM_QUEUE_CONTROL_MAX_DEFER 10000    // Control waits this long for a quiet channel
 
 // Routing Table Configuration
-#define RM_MAX_ROUTING_ENTRIES     1000
+#define RM_MAX_ROUTING_ENTRIES     512      // Preallocated at boot
+#define RM_ROUTE_TABLE_SLOTS       1024     // Hash index slots (power of two, >= 2x entries)
+#define RM_MAX_ADDRESSES           768      // Interned node addresses
+#define RM_ADDRESS_TABLE_SLOTS     2048     // Address hash index slots (power of two)
+#define RM_ADDRESS_GRACE_MS        10000    // Recently used addresses survive collection
 #define RM_MAX_SUBDOMAIN_NODES     200
 #define RM_MAX_INTERMEDIARY_MEMORY 500
 
+// Route Selection Configuration
+#define RM_ROUTE_CANDIDATES        3        // Next hops kept per destination
+#define RM_ROUTE_FAILOVER_RELIABILITY 50    // Primary below this hands over to the next candidate
+#define RM_ROUTE_MIN_RELIABILITY   20       // Candidates below this are dropped
+#define RM_ROUTE_SWITCH_MARGIN     0.5f     // Cost a candidate must save to displace a healthy primary
+#define RM_METRIC_WEIGHT_HOPS      1.0f     // Cost per hop
+#define RM_METRIC_WEIGHT_ETX       1.0f     // Cost per expected transmission
+#define RM_METRIC_WEIGHT_LATENCY   0.0f     // Cost per second of ACK round trip
+#define RM_METRIC_WEIGHT_PREFERENCE 1.0f    // Bonus per point of static preference
+
+// Neighbor Table Configuration
+#define RM_MAX_NEIGHBORS           32
+#define RM_NEIGHBOR_TIMEOUT        600000   // Neighbors unheard this long no longer count
+#define RM_NEIGHBOR_EWMA_ALPHA     0.25f    // Weight of each new RSSI/SNR sample
+#define RM_NEIGHBOR_PRR_WINDOW     16       // Expected frames per reception ratio sample
+#define RM_NEIGHBOR_PRR_ALPHA      0.3f     // Weight of each completed PRR window
+#define RM_NEIGHBOR_MAX_SEQ_GAP    64       // Larger jumps mean the neighbor restarted
+#define RM_NEIGHBOR_MAX_ETX        16.0f    // ETX of unknown or unusable links
+
+// Delivery Tracking Configuration
+#define RM_MAX_OUTSTANDING_MESSAGES 16      // Unacknowledged direct messages tracked for retry
+
+// Route Discovery Configuration
+#define RM_ROUTE_DISCOVERY_RETRIES 2        // Requests after the first before flooding
+#define RM_ROUTE_DISCOVERY_RING    3        // Hop limit of the first request (expanding ring)
+#define RM_MAX_PENDING_DISCOVERIES 8
+#define RM_DISCOVERY_BUFFER_SIZE   4        // Data packets held per pending destination
+#define RM_ROUTE_REPLY_MIN_RELIABILITY 50   // Weaker cached routes don't answer route requests
+
+// Fragmentation Configuration
+#define RM_FRAGMENT_MAX_AIRTIME_MS 4000     // Fragments are sized to stay under this on the next hop's profile
+#define RM_FRAGMENT_MIN_SIZE       32       // Smallest fragment data size, whatever the airtime
+#define RM_FRAGMENT_MAX_COUNT      32       // One bit each in the NACK bitmap
+#define RM_FRAGMENT_MAX_MESSAGE    2048     // Longest message we fragment or reassemble
+#define RM_FRAGMENT_QUEUE_DEPTH    2        // Fragments of one message waiting in the transmit queue
+#define RM_MAX_FRAGMENTED_MESSAGES 4        // Outgoing fragmented messages in flight
+#define RM_REASSEMBLY_MEMORY       4096     // Bytes shared by all reassembly buffers
+#define RM_REASSEMBLY_TIMEOUT_MS   60000    // Messages with no new fragment this long are dropped
+
+// Payload Compression Configuration
+#define RM_COMPRESSION_ENABLED     1        // Chat text uses the static dictionary coder when shorter
+
+// Frame Aggregation Configuration
+#define RM_AGGREGATE_ENABLED       1        // 0 = every frame pays its own preamble
+#define RM_AGGREGATE_MAX_FRAME     96       // Larger frames always go out on their own
+#define RM_AGGREGATE_HOLD_MS       150      // Longest a small frame waits for companions
+
+// Duplicate Suppression Configuration
+#define RM_SEEN_CACHE_SIZE         640      // Recently seen (source, messageId) pairs: ~1 new message/s for RM_MESSAGE_MAX_AGE
+#define RM_SEEN_FILTER_SIZE        2048     // Counting filter slots (power of two, ~3x the cache)
+
+// Managed Flooding Configuration
+#define RM_REBROADCAST_SLOTS       8        // SNR-ranked contention window slots
+#define RM_REBROADCAST_SLOT_MS     100      // Added to the frame's airtime to make one slot
+#define RM_REBROADCAST_JITTER_MS   50       // Random spread inside a slot
+#define RM_REBROADCAST_COPIES      2        // Cancel after overhearing this many relays
+#define RM_MAX_PENDING_REBROADCASTS 8
+#define RM_REBROADCAST_SNR_MIN     -20.0f   // SNR mapped to the earliest slot
+#define RM_REBROADCAST_SNR_MAX     10.0f    // SNR mapped to the latest slot
+
+// Channel Access Configuration (listen before talk)
+#define RM_CAD_BACKOFF_SLOT_MS     250      // Backoff unit after CAD finds the channel busy
+#define RM_CAD_BACKOFF_MAX_EXP     4        // Window doubles up to 2^4 slots
+#define RM_CAD_MAX_ATTEMPTS        6        // Give up on a frame after this many busy CADs
+#define RM_CAD_TIMEOUT_SYMBOLS     16       // Restart a CAD that hasn't signalled CadDone by then
+#define RM_CHANNEL_SAMPLE_MS       5000     // Channel utilization sampling window
+
+// Adaptive Data Rate Configuration (per-neighbor radio profiles)
+#define RM_ADR_ENABLED             1        // 0 = everything on the control profile
+#define RM_PROFILE_FAST_SF         7
+#define RM_PROFILE_FAST_BW_KHZ     125.0
+#define RM_PROFILE_FAST_PREAMBLE   320      // Outlasts two CAD scans of all profiles, plus sync
+#define RM_PROFILE_MEDIUM_SF       9
+#define RM_PROFILE_MEDIUM_BW_KHZ   125.0
+#define RM_PROFILE_MEDIUM_PREAMBLE 80
+#define RM_PROFILE_SLOW_PREAMBLE   16       // Control preamble of nodes that scan (others use RM_PREAMBLE_LENGTH)
+#define RM_ADR_CAD_SYMBOLS         4        // Symbols one scan CAD occupies, with overhead
+#define RM_ADR_SYNC_SYMBOLS        5        // Preamble a receiver still needs after a CAD hit
+#define RM_ADR_MARGIN_DB           10.0f    // SNR above the demodulation floor a profile needs
+#define RM_ADR_HYSTERESIS_DB       3.0f     // Extra margin before moving to a faster profile
+#define RM_ADR_LINK_TIMEOUT        600000   // Unheard links fall back to the control profile
+#define RM_ADR_MAX_LINKS           32
+
+// Duty Cycle Configuration (EU868 sub-band limits)
+#define RM_DUTY_CYCLE_WINDOW_MS    3600000  // Airtime is budgeted over a sliding hour
+#define RM_DUTY_CYCLE_BUCKETS      60       // Window granularity (one minute per bucket)
+#define RM_DUTY_SHARE_DIRECT       90       // % of the budget direct traffic may use
+#define RM_DUTY_SHARE_PUBLIC       75       // % of the budget public traffic may use
+#define RM_DUTY_SHARE_CONTROL      60       // % of the budget control traffic may use
+
 // Network Configuration
 #define RM_NETWORK_JOIN_RETRIES    3
-#define RM_MAX_RETRY_ATTEMPTS      3
+#define RM_MAX_RETRY_ATTEMPTS      3        // At most 3: the count travels in 2 header bits
 #define RM_CONGESTION_THRESHOLD    80       // Percentage
 #define RM_UUID_LENGTH             8        // bytes
 #define RM_NAME_TIMEOUT_MS         30000    // Name conflict timeout (30 seconds)
@@ -114,7 +223,10 @@
 #define RM_DEBUG_MESSAGES          1
 
 // Version Information
-#define RM_PROTOCOL_VERSION        1
+#define RM_PROTOCOL_V1             1        // 27-byte header, addresses as strings
+#define RM_PROTOCOL_V2             2        // 22-byte header, hashed numeric addresses
+#define RM_PROTOCOL_VERSION        RM_PROTOCOL_V2 // Version of the frames we originate
+#define RM_HEARTBEAT_FORMAT        1        // Binary heartbeat payload layout
 #define RM_FIRMWARE_VERSION        "0.1.0"
 
 #endif // REALMESH_CONFIG_H
\ No newline at end of file
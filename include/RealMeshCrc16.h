@@ -0,0 +1,53 @@
+#ifndef REALMESH_CRC16_H
+#define REALMESH_CRC16_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// ============================================================================
+// CRC-16/CCITT-FALSE
+// ============================================================================
+//
+// Polynomial 0x1021, initial value 0xFFFF, no reflection. The lookup table
+// is built at compile time, so it lives in flash and costs nothing at boot.
+// update() may be called repeatedly to checksum a frame as it is built.
+
+struct RealMeshCrc16Table {
+    uint16_t entries[256];
+    
+    constexpr RealMeshCrc16Table() : entries() {
+        for (uint16_t i = 0; i < 256; i++) {
+            uint16_t crc = i << 8;
+            for (uint8_t bit = 0; bit < 8; bit++) {
+                crc = (crc & 0x8000) ? (uint16_t)(crc << 1) ^ 0x1021 : (uint16_t)(crc << 1);
+            }
+            entries[i] = crc;
+        }
+    }
+};
+
+class RealMeshCrc16 {
+public:
+    static constexpr uint16_t INITIAL = 0xFFFF;
+    
+    static constexpr uint16_t update(uint16_t crc, const uint8_t* data, size_t length) {
+        for (size_t i = 0; i < length; i++) {
+            crc = (uint16_t)(crc << 8) ^ TABLE.entries[(uint8_t)(crc >> 8) ^ data[i]];
+        }
+        return crc;
+    }
+    
+    static constexpr uint16_t compute(const uint8_t* data, size_t length) {
+        return update(INITIAL, data, length);
+    }
+
+private:
+    static constexpr RealMeshCrc16Table TABLE = RealMeshCrc16Table();
+};
+
+namespace {
+constexpr uint8_t RM_CRC16_CHECK_INPUT[] = {'1', '2', '3', '4', '5', '6', '7', '8', '9'};
+static_assert(RealMeshCrc16::compute(RM_CRC16_CHECK_INPUT, 9) == 0x29B1, "CRC-16/CCITT-FALSE check value");
+}
+
+#endif // REALMESH_CRC16_H
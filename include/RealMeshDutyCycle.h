@@ -0,0 +1,46 @@
+#ifndef REALMESH_DUTY_CYCLE_H
+#define REALMESH_DUTY_CYCLE_H
+
+#include "RealMeshTypes.h"
+
+// ============================================================================
+// EU868 Duty-Cycle Ledger
+// ============================================================================
+//
+// Tracks our own airtime per ETSI sub-band over a sliding window built from
+// RM_DUTY_CYCLE_BUCKETS time buckets. Each priority may only spend part of
+// the sub-band budget, so lower priorities run out first and emergency
+// traffic always keeps the remainder.
+
+class RealMeshDutyCycle {
+public:
+    RealMeshDutyCycle();
+    
+    // Select the sub-band whose limit applies to further transmissions
+    void setFrequency(float freqMhz);
+    
+    // Would a frame of this airtime stay within this priority's share?
+    bool canTransmit(uint32_t airtimeMs, uint8_t priority);
+    
+    // Charge airtime to the current sub-band
+    void recordTransmission(uint32_t airtimeMs);
+    
+    // Current sub-band usage
+    uint32_t getUsedAirtime();                 // ms spent within the window
+    uint32_t getBudget() const;                // ms allowed within the window
+    uint8_t getUsagePercent();                 // Share of the budget used (0-100)
+    
+private:
+    static const uint8_t SUBBAND_COUNT = 6;    // Five EU868 sub-bands plus "other"
+    
+    uint32_t airtime[SUBBAND_COUNT][RM_DUTY_CYCLE_BUCKETS];
+    uint32_t currentEpoch;                     // Bucket number of the newest bucket
+    uint8_t subBand;
+    
+    void advance();
+    static uint8_t subBandFor(float freqMhz);
+    static uint16_t dutyPermille(uint8_t band);
+    static uint8_t sharePercent(uint8_t priority);
+};
+
+#endif // REALMESH_DUTY_CYCLE_H
@@ -0,0 +1,55 @@
+#ifndef REALMESH_LINK_PROFILES_H
+#define REALMESH_LINK_PROFILES_H
+
+#include "RealMeshTypes.h"
+
+// ============================================================================
+// Per-Neighbor Radio Profiles (Adaptive Data Rate)
+// ============================================================================
+//
+// Picks the fastest profile each neighbor's link can carry from the SNR of
+// frames we hear from it, assuming the link is roughly symmetric. Floods,
+// broadcasts and unknown or stale neighbors use the SLOW control profile,
+// which every node can always hear. A node scans the faster profiles with
+// CAD only while one of its links uses them; otherwise it stays in
+// continuous RX on SLOW. Links are symmetric, so the neighbors that send
+// fast frames to a scanning node scan too, and only scanning nodes send
+// control frames with the longer RM_PROFILE_SLOW_PREAMBLE.
+
+class RealMeshLinkProfiles {
+public:
+    RealMeshLinkProfiles();
+    
+    // Update a neighbor's link from a frame it transmitted
+    void recordReception(uint16_t shortId, float snr);
+    
+    // Profile to use towards a neighbor (0 = broadcast, control profile).
+    // Sending the same message to it again means the last attempt failed,
+    // so a resend goes one profile slower.
+    RadioProfile profileFor(uint16_t shortId, uint32_t messageId = 0) const;
+    
+    // Commit the choice made by profileFor() for a frame about to go out
+    void recordTransmission(uint16_t shortId, uint32_t messageId, RadioProfile profile);
+    
+    // Some live link uses this profile; a node scans while any uses FAST or MEDIUM
+    bool inUse(RadioProfile profile) const;
+    bool needsScan() const;
+    
+    size_t getLinkCount() const;
+    void printLinks() const;
+    
+    static const RadioProfileParams& params(RadioProfile profile);
+    static uint16_t preambleLength(RadioProfile profile, bool scanning);
+    static uint32_t airtimeMs(RadioProfile profile, size_t bytes, bool scanning = false);
+    
+private:
+    LinkProfileEntry links[RM_ADR_MAX_LINKS];
+    
+    LinkProfileEntry* find(uint16_t shortId);
+    const LinkProfileEntry* find(uint16_t shortId) const;
+    LinkProfileEntry* allocate(uint16_t shortId);
+    static RadioProfile selectProfile(float snr, RadioProfile current);
+    static float demodulationFloor(uint8_t spreadingFactor);
+};
+
+#endif // REALMESH_LINK_PROFILES_H
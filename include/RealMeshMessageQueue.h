@@ -0,0 +1,61 @@
+#ifndef REALMESH_MESSAGE_QUEUE_H
+#define REALMESH_MESSAGE_QUEUE_H
+
+#include "RealMeshTypes.h"
+#include <deque>
+#include <vector>
+#include <functional>
+
+// ============================================================================
+// Per-Priority Transmit Queues
+// ============================================================================
+//
+// One queue per MessagePriority, drained emergency > direct > public > control.
+// Each queue has its own drop policy:
+//   emergency - never aged out or shed for load
+//   direct    - FIFO, oldest evicted when full or past RM_QUEUE_DIRECT_MAX_AGE
+//   public    - small, capacity and age limit shrink as network load grows
+//   control   - deferred while the channel is congested, not aged out
+// A packet already waiting (same source and messageId) is never queued twice.
+// Entries hold a pool handle, so queueing shares the packet, never copies it.
+
+class RealMeshMessageQueue {
+public:
+    RealMeshMessageQueue();
+    
+    // Queue a packet by its header priority (false if dropped)
+    bool enqueue(const PacketHandle& packet, uint8_t networkLoad);
+    
+    // Next entry to transmit in priority order (nullptr if nothing is due),
+    // passing over entries `skip` accepts (frames held for aggregation)
+    QueueEntry* peek(uint8_t networkLoad,
+                     const std::function<bool(const QueueEntry&)>& skip = nullptr);
+    
+    // Remove the entry returned by peek()
+    void pop(const QueueEntry* entry);
+    
+    // Evict entries past their queue's age limit (returns number evicted)
+    size_t expire(uint8_t networkLoad);
+    
+    // Visit every waiting entry in drain order, then remove a chosen set
+    // (frames packed into one aggregate transmission)
+    void forEach(const std::function<void(const QueueEntry&)>& visit) const;
+    void remove(const std::vector<const QueueEntry*>& entries);
+    
+    size_t size() const;
+    size_t size(MessagePriority priority) const;
+    uint32_t getDropped() const { return dropped; }
+    
+private:
+    static const uint8_t QUEUE_COUNT = PRIORITY_CONTROL + 1;
+    
+    std::deque<QueueEntry> queues[QUEUE_COUNT];
+    uint32_t dropped;
+    
+    static uint8_t queueIndex(uint8_t priority);
+    static size_t capacityOf(uint8_t queue, uint8_t networkLoad);
+    static uint32_t maxAgeOf(uint8_t queue, uint8_t networkLoad);
+    bool isQueued(const MessagePacket& packet) const;
+};
+
+#endif // REALMESH_MESSAGE_QUEUE_H
@@ -38,6 +38,9 @@ public:
     // Message notification (called when messages are received)
     void notifyMessageReceived(const String& from, const String& message);
     
+    // Delivery notification (called when a direct message is ACKed or given up on)
+    void notifyDeliveryStatus(uint32_t messageId, const String& to, DeliveryStatus status);
+    
     // JSON API methods
     String processJsonCommand(const String& jsonStr);
     String getStatus();
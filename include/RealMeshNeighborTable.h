@@ -0,0 +1,46 @@
+#ifndef REALMESH_NEIGHBOR_TABLE_H
+#define REALMESH_NEIGHBOR_TABLE_H
+
+#include "RealMeshTypes.h"
+
+// ============================================================================
+// Neighbor Table and Link Estimator
+// ============================================================================
+//
+// One entry per node we hear directly, keyed by short ID. RSSI and SNR are
+// tracked as EWMA mean and variance over every frame the neighbor transmits.
+// Packet reception ratio comes from gaps in the sequence numbers of frames
+// the neighbor originated; relayed frames carry someone else's sequence and
+// only contribute signal samples. ETX assumes a symmetric link: 1 / PRR^2.
+
+class RealMeshNeighborTable {
+public:
+    RealMeshNeighborTable();
+    
+    // Account a frame transmitted by a neighbor. `originated` means the
+    // neighbor is the packet's source, so `sequence` is its own counter.
+    // Returns true if the neighbor is new (or was heard again after expiring).
+    bool recordFrame(uint16_t shortId, int16_t rssi, float snr, bool originated, uint16_t sequence);
+    
+    // Lookup (nullptr if unknown or not heard within RM_NEIGHBOR_TIMEOUT)
+    const NeighborEntry* find(uint16_t shortId) const;
+    
+    // Link estimates (PRR 0 and RM_NEIGHBOR_MAX_ETX for unknown neighbors)
+    float getPrr(uint16_t shortId) const;
+    float getEtx(uint16_t shortId) const;
+    
+    size_t size() const;
+    void print() const;
+    
+private:
+    NeighborEntry entries[RM_MAX_NEIGHBORS];
+    
+    NeighborEntry* findSlot(uint16_t shortId);
+    NeighborEntry* allocate(uint16_t shortId);
+    void updateReceptionRatio(NeighborEntry& entry, uint16_t sequence);
+    static float prrOf(const NeighborEntry& entry);
+    static bool isActive(const NeighborEntry& entry);
+    static void updateEwma(float& mean, float& var, float sample);
+};
+
+#endif // REALMESH_NEIGHBOR_TABLE_H
@@ -49,15 +49,18 @@ public:
     bool sendMessage(const String& targetAddress, const String& message);
     bool sendPublicMessage(const String& message);
     bool sendEmergencyMessage(const String& message);
+    uint32_t getLastMessageId() const { return router ? router->getLastMessageId() : 0; }
     
     // Event callbacks
     typedef std::function<void(const String& from, const String& message)> OnMessageReceived;
     typedef std::function<void(const String& event, const String& details)> OnNetworkEvent;
     typedef std::function<void(NodeState oldState, NodeState newState)> OnStateChanged;
+    typedef std::function<void(uint32_t messageId, const String& to, DeliveryStatus status)> OnDeliveryStatus;
     
     void setOnMessageReceived(OnMessageReceived callback) { messageReceivedCallback = callback; }
     void setOnNetworkEvent(OnNetworkEvent callback) { networkEventCallback = callback; }
     void setOnStateChanged(OnStateChanged callback) { stateChangedCallback = callback; }
+    void setOnDeliveryStatus(OnDeliveryStatus callback) { deliveryStatusCallback = callback; }
     
     // Network information
     size_t getKnownNodesCount();
@@ -115,6 +118,7 @@ private:
     OnMessageReceived messageReceivedCallback;
     OnNetworkEvent networkEventCallback;
     OnStateChanged stateChangedCallback;
+    OnDeliveryStatus deliveryStatusCallback;
     
     // Initialization helpers
     bool loadStoredIdentity();
@@ -141,10 +145,12 @@ private:
     void handleStateTransition(NodeState oldState, NodeState newState);
     
     // Radio and router callbacks
-    void onRadioMessageReceived(const MessagePacket& packet, int16_t rssi, float snr);
+    void onRadioMessageReceived(const RealMeshPacketView& frame, int16_t rssi, float snr);
     void onRadioTransmitComplete(bool success, const String& error);
     void onRouterMessageForUs(const MessagePacket& packet);
+    void onReassembledMessage(const NodeAddress& source, const String& message);
     void onRouteUpdate(const String& update);
+    void onDeliveryStatus(uint32_t messageId, const NodeAddress& destination, DeliveryStatus status);
     
     // Maintenance tasks
     void runPeriodicMaintenance();
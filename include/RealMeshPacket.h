@@ -3,28 +3,56 @@
 
 #include "RealMeshTypes.h"
 #include <vector>
+#include <functional>
 #include <Arduino.h>
 
 // ============================================================================
 // Message Packet Serialization/Deserialization
 // ============================================================================
+//
+// Two wire formats, chosen by header.protocolVersion. v1 sends the header
+// struct as-is and both addresses as nodeId/subdomain strings plus UUID.
+// v2 packs the header into 22 bytes and sends addresses as hashes. It sends
+// the full form only where nodes learn names: heartbeats, route discovery
+// and name conflicts. Receivers map hashes back to names they know through
+// the resolvers. Unknown nodes get a "#<hash>" placeholder name, which
+// serializes back to the same hash.
 
 class RealMeshPacket {
+    friend class RealMeshPacketView;
+    
 public:
+    typedef std::function<bool(uint32_t addressHash, uint16_t shortId, NodeAddress& address)> NodeResolver;
+    typedef std::function<bool(uint16_t subdomainHash, String& subdomain)> SubdomainResolver;
+    
     // Serialize a message packet to byte array for transmission
     static std::vector<uint8_t> serialize(const MessagePacket& packet);
     
+    // Same, into a caller's buffer whose capacity is reused
+    static void serialize(const MessagePacket& packet, std::vector<uint8_t>& buffer);
+    
+    // Number of bytes serialize() would produce, without building the frame
+    static size_t serializedSize(const MessagePacket& packet);
+    
+    // Bytes ahead of the payload: header and both addresses
+    static size_t overheadSize(uint8_t version, MessageType type,
+                               const NodeAddress& source, const NodeAddress& destination);
+    
     // Deserialize byte array back to message packet
     static bool deserialize(const std::vector<uint8_t>& data, MessagePacket& packet);
+    static bool deserialize(const uint8_t* data, size_t length, MessagePacket& packet);
     
     // Calculate message ID based on source and content
     static uint32_t generateMessageId(const NodeAddress& source, uint32_t timestamp, uint16_t sequence);
     
-    // Validate packet header checksum
-    static bool validateChecksum(const MessageHeader& header);
+    // v2 address decoding: look up names for hashes heard on air
+    static void setAddressResolvers(NodeResolver nodes, SubdomainResolver subdomains);
+    static uint16_t subdomainHash(const String& subdomain);
     
-    // Calculate header checksum
-    static uint16_t calculateChecksum(const MessageHeader& header);
+    // Hash an address travels under; a "#<hash>" placeholder for a node
+    // heard only by hash yields that hash
+    static uint32_t wireAddressHash(const NodeAddress& address);
+    static bool isPlaceholder(const NodeAddress& address);
     
     // Create different types of packets
     static MessagePacket createDataPacket(
@@ -35,9 +63,12 @@ public:
         bool encrypted = false
     );
     
+    // Only the fields in `fields` are sent; receivers keep their last value
+    // of the rest
     static MessagePacket createHeartbeatPacket(
         const NodeAddress& source,
-        const HeartbeatData& heartbeat
+        const HeartbeatData& heartbeat,
+        uint8_t fields = HB_FIELD_ALL
     );
     
     static MessagePacket createAckPacket(
@@ -58,18 +89,98 @@ public:
         uint8_t maxHops = RM_MAX_HOP_COUNT
     );
     
+    static MessagePacket createRouteReplyPacket(
+        const NodeAddress& source,
+        const NodeAddress& requester,
+        const RouteReplyData& reply
+    );
+    
+    // Decode a MSG_ROUTE_REPLY payload
+    static bool parseRouteReply(const MessagePacket& packet, RouteReplyData& reply);
+    
+    // Part of a message too long for one frame. A zero fragment.messageId
+    // makes the packet's own messageId name the message (the last fragment).
+    static MessagePacket createFragmentPacket(
+        const NodeAddress& source,
+        const NodeAddress& destination,
+        const FragmentData& fragment,
+        MessagePriority priority = PRIORITY_DIRECT,
+        bool compressed = false
+    );
+    static bool parseFragment(const MessagePacket& packet, FragmentData& fragment);
+    static const size_t FRAGMENT_HEADER_SIZE = 8;
+    
+    // Bitmap of the fragments a receiver is still missing
+    static MessagePacket createNackPacket(
+        const NodeAddress& source,
+        const NodeAddress& destination,
+        uint32_t messageId,
+        uint32_t missing
+    );
+    static bool parseNack(const MessagePacket& packet, uint32_t& messageId, uint32_t& missing);
+    
+    // Several small frames behind one preamble: [version][MSG_AGGREGATE],
+    // then [length][frame] per member. The container is sent as built and
+    // split back into frames by the receiving radio. Built in place, as it
+    // goes straight into a pool slot.
+    static void initAggregate(MessagePacket& aggregate, const MessagePacket& first);
+    static bool appendToAggregate(MessagePacket& aggregate, const MessagePacket& frame); // false if it won't fit
+    static bool isAggregate(const uint8_t* data, size_t length);
+    static bool nextAggregateMember(const uint8_t* data, size_t length, size_t& offset,
+                                    const uint8_t*& member, size_t& memberLength);
+    static const size_t AGGREGATE_HEADER_SIZE = 2;
+    
+    // Heartbeat contents at wire precision, and decoding of a MSG_HEARTBEAT
+    // payload (summary.fields says which fields it carried)
+    static HeartbeatSummary summarizeHeartbeat(const HeartbeatData& heartbeat);
+    static bool parseHeartbeat(const MessagePacket& packet, HeartbeatSummary& summary);
+    
     // Utility functions
     static String packetToString(const MessagePacket& packet);
     static void printPacketDebug(const MessagePacket& packet);
     
 private:
+    // v2 address forms (first byte of each encoded address)
+    enum AddressForm : uint8_t {
+        ADDRESS_BROADCAST = 0x00,  // Nothing follows
+        ADDRESS_SUBDOMAIN = 0x01,  // Subdomain hash
+        ADDRESS_HASHED = 0x02,     // Address hash, subdomain hash, short ID
+        ADDRESS_FULL = 0x03        // v1 encoding
+    };
+    
+    static const size_t HEADER_V2_SIZE = 22;
+    static const size_t HEADER_V2_CHECKSUM = 20;
+    
+    static NodeResolver nodeResolver;
+    static SubdomainResolver subdomainResolver;
+    
+    static uint16_t nextSequenceNumber();
+    
+    // Per-version framing
+    static bool parseHeader(const uint8_t* data, size_t length, MessageHeader& header, size_t& headerSize);
+    static void patchHeader(uint8_t* frame, size_t length, MessageHeader header);
+    static uint16_t frameChecksum(const uint8_t* frame, size_t length, size_t checksumAt);
+    static bool deserializeAddress(uint8_t version, const uint8_t*& data, size_t& remaining, NodeAddress& address);
+    static bool skipAddress(uint8_t version, const uint8_t*& data, size_t& remaining, uint16_t* shortId);
+    static void serializeHeaderV2(std::vector<uint8_t>& buffer, const MessageHeader& header);
+    static void encodeHeaderV2(uint8_t* bytes, const MessageHeader& header);
+    static void serializeAddressV2(std::vector<uint8_t>& buffer, const NodeAddress& address, bool full);
+    static size_t serializedAddressSizeV2(const NodeAddress& address, bool full);
+    static bool deserializeAddressV2(const uint8_t*& data, size_t& remaining, NodeAddress& address);
+    static bool sendsFullSource(const MessageHeader& header);
+    static bool sendsFullDestination(const MessageHeader& header);
+    static String resolveSubdomain(uint16_t hash);
+    
     // Internal serialization helpers
     static void serializeNodeAddress(std::vector<uint8_t>& buffer, const NodeAddress& address);
+    static size_t serializedAddressSize(const NodeAddress& address);
     static bool deserializeNodeAddress(const uint8_t*& data, size_t& remaining, NodeAddress& address);
     static void serializeString(std::vector<uint8_t>& buffer, const String& str);
     static bool deserializeString(const uint8_t*& data, size_t& remaining, String& str);
     static void serializeUUID(std::vector<uint8_t>& buffer, const NodeUUID& uuid);
     static bool deserializeUUID(const uint8_t*& data, size_t& remaining, NodeUUID& uuid);
+    static void serializeVarint(std::vector<uint8_t>& buffer, uint32_t value);
+    static bool deserializeVarint(const uint8_t*& data, size_t& remaining, uint32_t& value);
 };
 
 #endif // REALMESH_PACKET_H
\ No newline at end of file
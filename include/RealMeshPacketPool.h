@@ -0,0 +1,44 @@
+#ifndef REALMESH_PACKET_POOL_H
+#define REALMESH_PACKET_POOL_H
+
+#include "RealMeshTypes.h"
+
+// ============================================================================
+// Fixed Packet Pool
+// ============================================================================
+//
+// Every packet held past the call that built it lives in one of
+// RM_PACKET_POOL_SIZE static slots, reached through a PacketHandle. A
+// received frame is decoded straight into a slot, and the radio -> router
+// -> queue -> radio path passes that slot along. Relays, rebroadcasts and
+// discovery buffers share it instead of copying the packet. Memory use is
+// fixed at boot, and long-running relays don't fragment the heap. When
+// every slot is taken, acquire() fails and the packet is dropped like a
+// full queue would drop it.
+
+class RealMeshPacketPool {
+public:
+    // Blank packet, or an empty handle if the pool is exhausted
+    static PacketHandle acquire();
+    
+    // Copy of a packet built elsewhere (factories, retries)
+    static PacketHandle acquire(const MessagePacket& packet);
+    
+    static size_t available();
+    static size_t capacity() { return RM_PACKET_POOL_SIZE; }
+    static uint32_t getExhausted() { return exhausted; }   // Failed acquires
+
+private:
+    friend class PacketHandle;
+    
+    static MessagePacket slots[RM_PACKET_POOL_SIZE];
+    static uint8_t refCounts[RM_PACKET_POOL_SIZE];
+    static uint8_t nextSlot;                               // Where the search for a free slot starts
+    static uint32_t exhausted;
+    
+    static void retain(MessagePacket* packet);
+    static void release(MessagePacket* packet);
+    static uint8_t refCount(const MessagePacket* packet);
+};
+
+#endif // REALMESH_PACKET_POOL_H
@@ -0,0 +1,55 @@
+#ifndef REALMESH_PACKET_VIEW_H
+#define REALMESH_PACKET_VIEW_H
+
+#include "RealMeshTypes.h"
+
+// ============================================================================
+// Lazy Frame Decoder
+// ============================================================================
+//
+// Non-owning view over a received frame. Only the header is decoded up
+// front (no heap, no Strings), so duplicate, hop-limit and next-hop checks
+// run before any address parsing. Addresses are located on demand, and
+// decode() builds a full MessagePacket only for frames worth handling.
+// The underlying buffer must outlive the view.
+
+class RealMeshPacketView {
+public:
+    RealMeshPacketView(const uint8_t* data, size_t length);
+    
+    // Header parsed and the frame checksum matches
+    bool isValid() const { return valid; }
+    
+    const MessageHeader& header() const { return parsedHeader; }
+    const uint8_t* data() const { return bytes; }
+    size_t length() const { return size; }
+    
+    // Originator's short ID without decoding its name (0 if unreadable)
+    uint16_t sourceShortId() const;
+    
+    // Whoever transmitted this copy: the last relay, else the originator
+    uint16_t transmitterShortId() const;
+    
+    // Destination is exactly this node (broadcasts don't match)
+    bool isAddressedTo(const NodeAddress& address) const;
+    
+    // Full decode; the packet keeps the raw frame for cut-through relaying
+    bool decode(MessagePacket& packet) const;
+    
+private:
+    const uint8_t* bytes;
+    size_t size;
+    MessageHeader parsedHeader;
+    size_t headerSize;
+    bool valid;
+    
+    // Located on first use
+    mutable bool addressesLocated;
+    mutable size_t destinationOffset;
+    mutable uint16_t sourceId;
+    
+    bool locateAddresses() const;
+    static bool matchString(const uint8_t*& data, size_t& remaining, const String& str);
+};
+
+#endif // REALMESH_PACKET_VIEW_H
@@ -4,6 +4,10 @@
 #include <RadioLib.h>
 #include "RealMeshTypes.h"
 #include "RealMeshPacket.h"
+#include "RealMeshPacketView.h"
+#include "RealMeshDutyCycle.h"
+#include "RealMeshAirtime.h"
+#include "RealMeshLinkProfiles.h"
 #include <functional>
 #include <vector>
 
@@ -14,7 +18,7 @@
 class RealMeshRadio {
 public:
     // Callback types for radio events
-    typedef std::function<void(const MessagePacket&, int16_t rssi, float snr)> OnMessageReceived;
+    typedef std::function<void(const RealMeshPacketView&, int16_t rssi, float snr)> OnMessageReceived;
     typedef std::function<void(bool success, const String& error)> OnTransmitComplete;
     
     // Constructor
@@ -26,10 +30,17 @@ public:
     // Shutdown radio
     void end();
     
-    // Send a message packet
+    // Start sending a message packet (non-blocking; result via OnTransmitComplete)
     bool sendPacket(const MessagePacket& packet);
     
-    // Check for incoming messages (call regularly in loop)
+    // Could sendPacket() take this packet now? (idle and within duty cycle)
+    bool canTransmit(const MessagePacket& packet);
+    
+    // Drop the frame sendPacket() took if it is still backing off from a
+    // busy channel (false if it is another frame, or already on air)
+    bool cancelTransmit(uint16_t sourceShortId, uint32_t messageId);
+    
+    // Finish transmissions and read received packets (call regularly in loop)
     void processIncoming();
     
     // Set callback functions
@@ -38,12 +49,21 @@ public:
     
     // Radio status and statistics
     bool isInitialized() const { return initialized; }
+    bool isTransmitting() const { return transmitting; }
+    uint32_t getLastRxTimestamp() const { return lastReception; }  // Captured in the DIO1 ISR
     float getCurrentRSSI();
     float getCurrentSNR();
     uint32_t getMessagesSent() const { return messagesSent; }
     uint32_t getMessagesReceived() const { return messagesReceived; }
     uint32_t getTransmitErrors() const { return transmitErrors; }
     uint32_t getReceiveErrors() const { return receiveErrors; }
+    uint32_t getChannelDeferrals() const { return channelDeferrals; }
+    uint32_t getChannelBusyDrops() const { return channelBusyDrops; }
+    uint32_t getDutyCycleDeferrals() const { return dutyCycleDeferrals; }
+    uint8_t getDutyCycleUsage() { return dutyCycle.getUsagePercent(); }
+    uint32_t getTxAirtime() const { return txAirtime; }          // ms we spent transmitting
+    uint32_t getRxAirtime() const { return rxAirtime; }          // ms of frames we received
+    uint32_t getBackoffTime() const { return backoffTime; }      // ms spent deferring to others
     
     // Channel management
     bool setFrequency(float freq);
@@ -54,14 +74,31 @@ public:
     
     // Network analysis
     bool isChannelBusy();
-    float getChannelUtilization();
-    void startChannelScan(uint32_t duration = 5000);
+    float getChannelUtilization();                          // Smoothed % of time on air (TX + RX)
+    void startChannelScan(uint32_t duration = RM_CHANNEL_SAMPLE_MS);  // Restart sampling with this window
+    
+    // Adaptive data rate
+    RadioProfile getLinkProfile(uint16_t shortId) const { return linkProfiles.profileFor(shortId); }
+    uint32_t getAirtimeMs(uint16_t shortId, size_t bytes) const;   // Frame towards a neighbor (0 = broadcast)
+    void printLinkProfiles() const { linkProfiles.printLinks(); }
     
     // Debug and testing
     void printRadioConfig();
     void runRadioTest();
     
 private:
+    // Idle path:     SCAN (CAD on each profile in turn) -> RX on a detection
+    //                Scan steps run in scanTask, woken by the CAD-done interrupt.
+    // Transmit path: CAD -> (BACKOFF -> CAD)* -> TX -> SCAN
+    // Without adaptive data rate the idle path is plain continuous RX.
+    enum RadioState : uint8_t {
+        RADIO_RX,
+        RADIO_SCAN,
+        RADIO_CAD,
+        RADIO_BACKOFF,
+        RADIO_TX
+    };
+    
     // RadioLib instances
     SX1262 radio;
     
@@ -71,6 +108,39 @@ private:
     bool receiving;
     uint32_t lastTransmission;
     uint32_t lastReception;
+    uint32_t txStartTime;
+    size_t txBytes;
+    std::vector<uint8_t> txFrame;    // Frame waiting for a clear channel
+    uint16_t txSourceId;             // Its originator (0 = aggregate, never cancelled)
+    uint32_t txMessageId;
+    
+    // Listen before talk
+    volatile RadioState radioState;
+    uint8_t cadAttempts;
+    uint32_t backoffUntil;
+    uint32_t cadDeadline;            // CadDone overdue after this (lost DIO1 edge), CAD or SCAN
+    
+    // Per-neighbor profiles
+    RealMeshLinkProfiles linkProfiles;
+    RadioProfile currentProfile;     // Modulation the chip is set to
+    RadioProfile txProfile;          // Modulation of the frame in txFrame
+    uint16_t txPreamble;
+    uint32_t txAirtimeMs;
+    uint16_t currentPreamble;        // Only set for transmissions; receivers take any length
+    uint8_t scanIndex;
+    uint32_t rxLockUntil;            // End of RX after a scan hit (0 = continuous RX)
+    TaskHandle_t scanTask;
+    SemaphoreHandle_t radioLock;     // SPI access from the loop vs. scanTask (recursive)
+    
+    // Regulatory airtime budget
+    RealMeshDutyCycle dutyCycle;
+    bool dutyCycleBlocked;           // Last canTransmit() was refused by the budget
+    
+    // Set by the DIO1 interrupt, consumed in processIncoming()
+    volatile bool txDoneFlag;
+    volatile bool rxDoneFlag;
+    volatile bool cadDoneFlag;
+    volatile uint32_t rxTimestamp;
     
     // Statistics
     uint32_t messagesSent;
@@ -79,10 +149,18 @@ private:
     uint32_t receiveErrors;
     uint32_t bytesTransmitted;
     uint32_t bytesReceived;
+    uint32_t channelDeferrals;       // CADs that found the channel busy
+    uint32_t channelBusyDrops;       // Frames abandoned after RM_CAD_MAX_ATTEMPTS
+    uint32_t dutyCycleDeferrals;     // Times the budget held traffic back
     
     // Channel monitoring
-    uint32_t channelBusyTime;
-    uint32_t channelSampleTime;
+    uint32_t channelBusyTime;        // Airtime seen in the current sample window
+    uint32_t channelSampleTime;      // Start of the current sample window
+    uint32_t channelSampleWindow;
+    float channelUtilization;
+    uint32_t txAirtime;
+    uint32_t rxAirtime;
+    uint32_t backoffTime;
     float avgRSSI;
     float avgSNR;
     
@@ -96,10 +174,27 @@ private:
     void handleReceiveError(int state);
     void handleTransmitError(int state);
     String getRadioStateString(int state);
+    bool isBusy() const;
+    bool applyProfile(RadioProfile profile, bool inStandby = false);
+    bool applyPreamble(uint16_t preambleLength);
+    void startListening(bool afterCad = false);
+    void handleScanResult();
+    void startChannelActivityDetection();
+    void handleChannelActivityResult();
+    void beginTransmit();
+    void completeTransmit(int state);
+    void advanceState();
+    size_t readReceivedPacket(uint32_t timestamp, uint8_t* data, float& rssi, float& snr);
+    void deliverFrames(const uint8_t* data, size_t length, float rssi, float snr);
+    void deliverFrame(const uint8_t* data, size_t length, float rssi, float snr);
+    void updateChannelUtilization();
     
     // Interrupt handlers (static)
+    static void onDio1Interrupt();
     static void onTransmitDone();
     static void onReceiveDone();
+    static void onChannelScanDone();
+    static void runScanTask(void* arg);
     static RealMeshRadio* instance; // For interrupt callbacks
 };
 
@@ -0,0 +1,58 @@
+#ifndef REALMESH_ROUTE_TABLE_H
+#define REALMESH_ROUTE_TABLE_H
+
+#include "RealMeshTypes.h"
+
+// ============================================================================
+// Fixed-Capacity Routing Table
+// ============================================================================
+//
+// Open-addressing hash index over a dense, preallocated entry pool. Lookups
+// are keyed by the destination's interned AddressHandle and never allocate;
+// the index only stores (handle, entry index) pairs so probing stays within a
+// few cache lines. Removal swaps the last entry into the freed slot to keep
+// the pool dense for iteration.
+
+class RealMeshRouteTable {
+public:
+    RealMeshRouteTable();
+    
+    // Lookup by destination (nullptr if unknown)
+    RoutingEntry* find(AddressHandle destination);
+    
+    // Find existing entry or create a new one (nullptr if table is full)
+    RoutingEntry* insert(AddressHandle destination);
+    
+    // Remove entry for destination (returns false if not present)
+    bool remove(AddressHandle destination);
+    
+    // Drop all entries
+    void clear();
+    
+    // Dense iteration: entries 0..size()-1 are always valid
+    size_t size() const { return count; }
+    size_t capacity() const { return RM_MAX_ROUTING_ENTRIES; }
+    bool isFull() const { return count >= RM_MAX_ROUTING_ENTRIES; }
+    RoutingEntry& at(size_t index) { return entries[index]; }
+    const RoutingEntry& at(size_t index) const { return entries[index]; }
+    
+private:
+    static const uint16_t SLOT_EMPTY = 0xFFFF;
+    static const uint16_t SLOT_DELETED = 0xFFFE;
+    
+    struct Slot {
+        AddressHandle destination;
+        uint16_t index;
+    };
+    
+    Slot slots[RM_ROUTE_TABLE_SLOTS];
+    RoutingEntry entries[RM_MAX_ROUTING_ENTRIES];
+    uint16_t count;
+    uint16_t deletedSlots;
+    
+    static uint32_t slotFor(AddressHandle destination);
+    int findSlot(AddressHandle destination) const;
+    void rebuildIndex();
+};
+
+#endif // REALMESH_ROUTE_TABLE_H
@@ -3,6 +3,12 @@
 
 #include "RealMeshTypes.h"
 #include "RealMeshPacket.h"
+#include "RealMeshPacketView.h"
+#include "RealMeshPacketPool.h"
+#include "RealMeshRouteTable.h"
+#include "RealMeshAddressTable.h"
+#include "RealMeshMessageQueue.h"
+#include "RealMeshNeighborTable.h"
 #include <map>
 #include <vector>
 #include <functional>
@@ -15,8 +21,14 @@ class RealMeshRouter {
 public:
     // Callback types
     typedef std::function<bool(const MessagePacket&)> OnSendPacket;
+    typedef std::function<bool(const MessagePacket&)> OnCanSend;
     typedef std::function<void(const MessagePacket&)> OnMessageForUs;
     typedef std::function<void(const String&)> OnRouteUpdate;
+    typedef std::function<void(uint32_t messageId, const NodeAddress& destination, DeliveryStatus status)> OnDeliveryStatus;
+    typedef std::function<float(const RouteCandidate&)> RouteCostFunction;
+    typedef std::function<uint32_t(uint16_t nextHopShortId, size_t bytes)> OnAirtime;
+    typedef std::function<void(const NodeAddress& source, const String& message)> OnReassembledMessage;
+    typedef std::function<bool(uint16_t sourceShortId, uint32_t messageId)> OnCancelSend;
     
     // Constructor
     RealMeshRouter(const NodeAddress& ownAddress);
@@ -24,17 +36,23 @@ public:
     // Initialize routing engine
     bool begin();
     
-    // Process incoming packet (returns true if we should forward it)
-    bool processIncomingPacket(const MessagePacket& packet, int16_t rssi, float snr);
+    // Process a received frame (returns true if we forwarded or handled it).
+    // Header checks run on the raw frame; addresses are decoded only after.
+    bool processIncomingFrame(const RealMeshPacketView& frame, int16_t rssi, float snr);
     
-    // Route an outgoing message
+    // Periodic processing (flood rebroadcasts, route discovery retries)
+    void loop();
+    
+    // Route an outgoing message (split into fragments when it won't fit
+    // one frame within RM_FRAGMENT_MAX_AIRTIME_MS)
     bool routeMessage(const NodeAddress& destination, const String& message, MessagePriority priority = PRIORITY_DIRECT);
     
     // Send different types of messages
     bool sendDirectMessage(const NodeAddress& destination, const String& message);
     bool sendPublicMessage(const String& message);
     bool sendEmergencyMessage(const String& message);
-    bool sendHeartbeat();
+    bool sendHeartbeat();                         // Call from loop; Trickle decides when to transmit
+    void resetHeartbeatTimer(const char* reason); // Topology changed: announce within RM_HEARTBEAT_IMIN
     
     // Routing table management
     void addRoute(const NodeAddress& destination, const NodeAddress& nextHop, uint8_t hopCount = 1);
@@ -42,6 +60,12 @@ public:
     void updateRouteQuality(const NodeAddress& destination, int16_t rssi, bool success);
     RoutingEntry* findRoute(const NodeAddress& destination);
     
+    // Route selection: candidates are ranked by a composite cost (lower wins)
+    void setRouteMetricPolicy(const RouteMetricPolicy& policy) { metricPolicy = policy; }
+    RouteMetricPolicy getRouteMetricPolicy() const { return metricPolicy; }
+    void setRouteCostFunction(RouteCostFunction function) { costFunction = function; }  // Replaces the policy
+    void setRoutePreference(const NodeAddress& destination, const NodeAddress& nextHop, uint8_t preference);
+    
     // Subdomain management
     void updateSubdomainInfo(const String& subdomain, const std::vector<NodeAddress>& nodes);
     std::vector<NodeAddress> getSubdomainNodes(const String& subdomain);
@@ -57,15 +81,31 @@ public:
     size_t getRoutingTableSize() const { return routingTable.size(); }
     size_t getSubdomainCount() const { return subdomains.size(); }
     size_t getIntermediaryCount() const { return intermediaryMemory.size(); }
+    size_t getQueuedCount() const { return txQueue.size(); }
+    size_t getNeighborCount() const { return neighbors.size(); }
+    float getLinkEtx(const NodeAddress& neighbor) const { return neighbors.getEtx(neighbor.uuid.getShortId()); }
     NetworkStats getNetworkStats() const { return stats; }
     
     // Configuration
     void setOwnStatus(NodeStatus status);
     NodeStatus getOwnStatus() const { return ownStatus; }
+    void setNetworkLoad(uint8_t load) { stats.networkLoad = min(load, (uint8_t)100); }
     void setCallbacks(OnSendPacket sendCallback, OnMessageForUs messageCallback, OnRouteUpdate routeCallback);
+    void setDeliveryCallback(OnDeliveryStatus callback) { deliveryCallback = callback; }
+    void setCanSendCallback(OnCanSend callback) { canSendCallback = callback; }
+    void setAirtimeCallback(OnAirtime callback) { airtimeCallback = callback; }
+    void setReassembledCallback(OnReassembledMessage callback) { reassembledCallback = callback; }
+    void setCancelSendCallback(OnCancelSend callback) { cancelSendCallback = callback; }
+    
+    // Delivery tracking
+    uint32_t getLastMessageId() const { return lastMessageId; }
+    size_t getOutstandingCount() const { return outstandingMessages.size(); }
+    size_t getReassemblyCount() const { return reassemblyBuffers.size(); }
     
     // Debugging
     void printRoutingTable();
+    void printNeighborTable() const { neighbors.print(); }
+    void printHeartbeats();
     void printSubdomainInfo();
     void printIntermediaryMemory();
     void printNetworkStats();
@@ -73,44 +113,155 @@ public:
 private:
     // Core data
     NodeAddress ownAddress;
+    AddressHandle ownHandle;
     NodeStatus ownStatus;
-    std::map<String, RoutingEntry> routingTable;  // Key: full address
+    RealMeshAddressTable addresses;               // Interned node addresses
+    RealMeshRouteTable routingTable;              // Key: destination handle
     std::map<String, SubdomainInfo> subdomains;   // Key: subdomain name
     std::vector<IntermediaryEntry> intermediaryMemory;
+    std::map<AddressHandle, PendingDiscovery> pendingDiscoveries; // Key: destination handle
+    std::vector<PendingRebroadcast> pendingRebroadcasts;
+    std::map<uint32_t, QueueEntry> outstandingMessages;    // Key: messageId awaiting ACK
+    std::map<uint32_t, FragmentedMessage> outgoingFragments; // Key: FragmentData::messageId
+    std::map<uint64_t, ReassemblyBuffer> reassemblyBuffers;  // Key: source handle << 32 | messageId
+    RealMeshMessageQueue txQueue;                 // Everything we transmit goes through here
+    RealMeshNeighborTable neighbors;              // Link estimates for nodes heard directly
+    uint32_t lastMessageId;
     NetworkStats stats;
     
+    // Duplicate suppression (ring buffer + counting filter)
+    SeenMessageEntry seenCache[RM_SEEN_CACHE_SIZE];
+    uint8_t seenFilter[RM_SEEN_FILTER_SIZE];
+    uint16_t seenCacheHead;
+    uint16_t seenCacheCount;
+    
     // Callbacks
     OnSendPacket sendCallback;
     OnMessageForUs messageCallback;
     OnRouteUpdate routeCallback;
+    OnDeliveryStatus deliveryCallback;
+    OnCanSend canSendCallback;
+    OnAirtime airtimeCallback;
+    OnReassembledMessage reassembledCallback;
+    OnCancelSend cancelSendCallback;
+    
+    // Route selection
+    RouteMetricPolicy metricPolicy;
+    RouteCostFunction costFunction;
     
     // Timing
     uint32_t lastHeartbeat;
+    
+    // Heartbeat Trickle timer
+    uint32_t heartbeatInterval;                   // Current interval I
+    uint32_t heartbeatIntervalStart;
+    uint32_t heartbeatSendAt;                     // Offset t in [I/2, I)
+    uint8_t heartbeatsHeard;                      // Consistent heartbeats heard this interval
+    bool heartbeatDecided;                        // Sent or suppressed this interval
+    HeartbeatSummary lastAnnounced;               // Baseline for delta heartbeats
+    uint8_t heartbeatsSinceFull;
+    std::map<AddressHandle, HeartbeatSummary> nodeHeartbeats; // Key: heartbeat source handle
     uint32_t lastRoutingTableCleanup;
     
     // Message processing helpers
+    bool handleIncomingPacket(PacketHandle packet, int16_t rssi, float snr);
     bool handleDataMessage(const MessagePacket& packet, int16_t rssi);
+    static bool payloadDecodes(const MessagePacket& packet);
     bool handleControlMessage(const MessagePacket& packet, int16_t rssi);
     bool handleHeartbeatMessage(const MessagePacket& packet, int16_t rssi);
     bool handleAckMessage(const MessagePacket& packet, int16_t rssi);
+    bool handleNackMessage(const MessagePacket& packet, int16_t rssi);
+    bool handleFragmentMessage(const MessagePacket& packet);
     bool handleNameConflictMessage(const MessagePacket& packet, int16_t rssi);
     
     // Routing logic
-    bool routePacketDirect(MessagePacket& packet);
-    bool routePacketSubdomain(MessagePacket& packet);
-    bool routePacketFlood(MessagePacket& packet);
-    bool shouldForwardPacket(const MessagePacket& packet);
-    void updatePathFromPacket(const MessagePacket& packet, int16_t rssi);
+    // The handle is detached before the header is rewritten, so other
+    // holders of the slot (retry entries, queued copies) keep their packet
+    bool dispatchPacket(PacketHandle& packet);
+    bool routePacketDirect(PacketHandle& packet);
+    bool routePacketSubdomain(PacketHandle& packet);
+    bool routePacketFlood(PacketHandle& packet);
+    bool shouldForwardPacket(PacketHandle packet, float snr);
+    void updatePathFromPacket(const MessagePacket& packet, AddressHandle source, int16_t rssi);
+    void learnRoute(AddressHandle destination, AddressHandle nextHop, uint8_t hopCount, int16_t rssi);
+    
+    // Route selection
+    RouteCandidate* findRouteCandidate(RoutingEntry& entry, AddressHandle nextHop);
+    RouteCandidate* addRouteCandidate(AddressHandle destination, AddressHandle nextHop);
+    void rankRouteCandidates(RoutingEntry& entry);
+    float routeCost(const RouteCandidate& candidate) const;
+    void recordRouteLatency(AddressHandle destination, uint32_t latencyMs);
+    
+    // Heartbeats
+    bool transmitHeartbeat();
+    void startHeartbeatInterval(uint32_t interval);
+    uint32_t maxHeartbeatInterval() const;
+    uint8_t changedHeartbeatFields(const HeartbeatSummary& current);
+    void rememberHeartbeat(AddressHandle source, const HeartbeatSummary& heartbeat);
+    
+    // Transmit queueing
+    bool enqueuePacket(const MessagePacket& packet);
+    bool enqueuePacket(const PacketHandle& packet);
+    void processTransmitQueue();
+    bool isAggregatable(const MessagePacket& packet) const;
+    bool transmitAggregate(QueueEntry* head);
+    
+    // Fragmentation
+    bool fragmentMessage(const NodeAddress& destination, const String& message, MessagePriority priority);
+    uint16_t fragmentChunkSize(const NodeAddress& destination, size_t messageLength);
+    size_t frameOverhead(MessageType type, const NodeAddress& destination) const;
+    uint32_t frameAirtime(const NodeAddress& destination, size_t bytes);
+    void processFragments();
+    bool reserveReassembly(ReassemblyBuffer& buffer, size_t bytes);
+    void cleanupReassembly();
+    static uint32_t fragmentMask(uint8_t count);
+    
+    // Reliable delivery
+    void sendAck(const MessagePacket& packet, uint32_t messageId);
+    void sendNack(const MessagePacket& packet, uint32_t messageId, uint32_t missing);
+    void replyToSource(const MessagePacket& packet, PacketHandle& reply);
+    void trackDelivery(const PacketHandle& packet, uint8_t routingFlags);
+    uint32_t retryInterval(const QueueEntry& entry, uint8_t routingFlags);
+    void processOutstandingMessages();
+    
+    // Managed flooding
+    bool scheduleRebroadcast(const PacketHandle& packet, float snr);
+    void noteOverheardCopy(uint16_t sourceId, uint32_t messageId);
+    void processRebroadcasts();
+    
+    // Duplicate suppression
+    bool isDuplicatePacket(uint16_t sourceId, uint32_t messageId, uint8_t retry = 0);
+    void rememberPacket(uint16_t sourceId, uint32_t messageId, uint8_t retry = 0);
+    static uint32_t seenMessageHash(uint16_t sourceId, uint32_t messageId);
+    
+    // Handle-based table operations
+    AddressHandle internAddress(const NodeAddress& address);
+    bool resolveNode(uint32_t hash, uint16_t shortId, NodeAddress& address) const;
+    bool resolveSubdomain(uint16_t hash, String& subdomain) const;
+    void collectAddresses();
+    void addRoute(AddressHandle destination, AddressHandle nextHop, uint8_t hopCount);
+    void removeRoute(AddressHandle destination);
+    void updateRouteQuality(AddressHandle destination, int16_t rssi, bool success);
+    RoutingEntry* findRoute(AddressHandle destination);
+    void recordBridge(AddressHandle nodeA, AddressHandle nodeB);
+    void addStationaryHub(AddressHandle hub);
     
     // Subdomain routing intelligence
-    std::vector<NodeAddress> findSubdomainHelpers(const String& targetSubdomain);
+    std::vector<AddressHandle> findSubdomainHelpers(const String& targetSubdomain);
     bool isInOurSubdomain(const NodeAddress& address);
     void broadcastToSubdomain(const MessagePacket& packet);
     
     // Route discovery
+    bool bufferForDiscovery(const PacketHandle& packet);
     void initiateRouteDiscovery(const NodeAddress& destination);
+    void sendRouteRequest(AddressHandle destination, PendingDiscovery& pending);
     void handleRouteRequest(const MessagePacket& packet);
     void handleRouteReply(const MessagePacket& packet);
+    bool answerRouteRequest(const MessagePacket& packet);
+    void sendRouteReply(const MessagePacket& request, const RouteReplyData& reply);
+    void learnFromRouteReply(const MessagePacket& packet, int16_t rssi);
+    void completeRouteDiscovery(AddressHandle destination);
+    void processRouteDiscoveries();
     
     // Table maintenance
     void cleanupRoutingTable();
@@ -119,12 +270,12 @@ private:
     bool isRouteExpired(const RoutingEntry& entry);
     
     // Utility functions
-    String addressToKey(const NodeAddress& address);
     bool isValidPacket(const MessagePacket& packet);
     bool isPacketForUs(const MessagePacket& packet);
     void addToPathHistory(MessagePacket& packet);
     bool isInPathHistory(const MessagePacket& packet, const NodeAddress& address);
     uint8_t calculateHopDistance(const NodeAddress& destination);
+    float linkEtx(AddressHandle neighbor) const;
 };
 
 #endif // REALMESH_ROUTER_H
\ No newline at end of file
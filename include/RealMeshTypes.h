@@ -19,7 +19,9 @@ enum MessageType : uint8_t {
     MSG_NACK = 0x05,
     MSG_ROUTE_REQUEST = 0x06,
     MSG_ROUTE_REPLY = 0x07,
-    MSG_NAME_CONFLICT = 0x08
+    MSG_NAME_CONFLICT = 0x08,
+    MSG_FRAGMENT = 0x09,
+    MSG_AGGREGATE = 0x0A         // Container of whole frames, never routed itself
 };
 
 // Message Priority
@@ -36,7 +38,32 @@ enum RoutingFlags : uint8_t {
     ROUTE_SUBDOMAIN_RETRY = 0x02,
     ROUTE_FLOOD = 0x04,
     ROUTE_INTERMEDIARY_ASSIST = 0x08,
-    ROUTE_ENCRYPTED = 0x10
+    ROUTE_ENCRYPTED = 0x10,
+    ROUTE_COMPRESSED = 0x20,     // Payload is RealMeshCompression-encoded
+    ROUTE_RETRY_MASK = 0xC0      // Originator's retry count for a resend
+};
+
+// Flags describing the payload rather than the route; routing keeps them
+#define RM_PAYLOAD_FLAGS           (ROUTE_ENCRYPTED | ROUTE_COMPRESSED)
+
+// Retry count carried in ROUTE_RETRY_MASK. A flooded resend reuses the
+// messageId, so relays pass it on only when the count is higher.
+#define RM_RETRY_SHIFT             6
+#define RM_ROUTE_RETRY(flags)      (((flags) & ROUTE_RETRY_MASK) >> RM_RETRY_SHIFT)
+
+// Delivery Status (reported for tracked direct messages)
+enum DeliveryStatus : uint8_t {
+    DELIVERY_PENDING = 0x00,
+    DELIVERY_ACKED = 0x01,
+    DELIVERY_FAILED = 0x02
+};
+
+// Radio Link Profile (fastest first; SLOW is the common control profile)
+enum RadioProfile : uint8_t {
+    PROFILE_FAST = 0x00,
+    PROFILE_MEDIUM = 0x01,
+    PROFILE_SLOW = 0x02,
+    PROFILE_COUNT = 0x03
 };
 
 // Node Status
@@ -63,6 +90,19 @@ struct NodeUUID {
         }
         return result;
     }
+    
+    // 16-bit identifier carried in path history (0 means "empty slot")
+    uint16_t getShortId() const {
+        uint16_t id = ((uint16_t)bytes[0] << 8) | bytes[1];
+        return id != 0 ? id : 1;
+    }
+    
+    bool isSet() const {
+        for (int i = 0; i < RM_UUID_LENGTH; i++) {
+            if (bytes[i] != 0) return true;
+        }
+        return false;
+    }
 };
 
 // Node Address Structure
@@ -75,6 +115,23 @@ struct NodeAddress {
         return nodeId + "@" + subdomain;
     }
     
+    // FNV-1a over "nodeId@subdomain" without building the string
+    uint32_t getAddressHash() const {
+        uint32_t hash = 2166136261u;
+        for (const char* p = nodeId.c_str(); *p; p++) {
+            hash = (hash ^ (uint8_t)*p) * 16777619u;
+        }
+        hash = (hash ^ (uint8_t)'@') * 16777619u;
+        for (const char* p = subdomain.c_str(); *p; p++) {
+            hash = (hash ^ (uint8_t)*p) * 16777619u;
+        }
+        return hash;
+    }
+    
+    bool sameAddress(const NodeAddress& other) const {
+        return nodeId == other.nodeId && subdomain == other.subdomain;
+    }
+    
     String getInternalAddress() const {
         return nodeId + "@" + subdomain + "_" + uuid.toString().substring(0, 4);
     }
@@ -84,10 +141,15 @@ struct NodeAddress {
     }
 };
 
-// Message Header Structure (32 bytes)
+// Interned Address Handle (index into the router's address table)
+typedef uint16_t AddressHandle;
+#define RM_INVALID_ADDRESS         0xFFFF
+
+// Message Header Structure (27 bytes, budgeted as RM_HEADER_SIZE). This is
+// the v1 wire layout; v2 frames pack the same fields minus the timestamp.
 struct __attribute__((packed)) MessageHeader {
     uint32_t messageId;          // Unique message identifier
-    uint32_t timestamp;          // Unix timestamp
+    uint32_t timestamp;          // Unix timestamp (0 in v2 frames)
     uint16_t sequenceNumber;     // Message sequence
     uint8_t protocolVersion;     // Protocol version
     uint8_t messageType;         // MessageType enum
@@ -96,9 +158,9 @@ struct __attribute__((packed)) MessageHeader {
     uint8_t hopCount;            // Current hop count
     uint8_t maxHops;             // Maximum allowed hops
     uint8_t payloadLength;       // Payload size in bytes
-    uint8_t reserved;            // Reserved for future use
-    uint8_t pathHistory[RM_PATH_HISTORY_SIZE]; // Last 3 hop node IDs
-    uint16_t checksum;           // Header checksum
+    uint16_t pathHistory[RM_PATH_HISTORY_SIZE]; // Last 3 transmitters (short IDs, newest first)
+    uint16_t nextHop;            // Short ID of the only node that may relay (0 = any)
+    uint16_t checksum;           // CRC-16 of the whole frame, stamped by serialize()
 };
 
 // Complete Message Packet
@@ -108,27 +170,84 @@ struct MessagePacket {
     NodeAddress destination;
     uint8_t payload[RM_MAX_PAYLOAD_SIZE];
     
+    // Frame as received, so relays can send it on without re-encoding
+    // (0 = built locally, encode from the fields above)
+    uint8_t wireLength;
+    uint8_t wire[RM_MAX_PACKET_SIZE];
+    
     size_t getTotalSize() const {
         return sizeof(MessageHeader) + header.payloadLength;
     }
 };
 
+// Shared reference to a MessagePacket in RealMeshPacketPool. Copies share
+// the slot, which goes back to the pool when the last handle lets go.
+class PacketHandle {
+public:
+    PacketHandle() : packet(nullptr) {}
+    PacketHandle(const PacketHandle& other);
+    PacketHandle(PacketHandle&& other) : packet(other.packet) { other.packet = nullptr; }
+    PacketHandle& operator=(const PacketHandle& other);
+    PacketHandle& operator=(PacketHandle&& other);
+    ~PacketHandle() { reset(); }
+    
+    explicit operator bool() const { return packet != nullptr; }
+    MessagePacket& operator*() const { return *packet; }
+    MessagePacket* operator->() const { return packet; }
+    
+    void reset();
+    
+    // Another handle holds the same slot
+    bool isShared() const;
+    
+    // Take a private copy before changing a shared packet (false if the
+    // pool has no free slot)
+    bool detach();
+    
+private:
+    friend class RealMeshPacketPool;
+    explicit PacketHandle(MessagePacket* slot) : packet(slot) {}
+    
+    MessagePacket* packet;
+};
+
+// Route Candidate (one possible next hop towards a destination)
+struct RouteCandidate {
+    uint32_t lastUpdated;        // Last time this path was heard or used
+    AddressHandle nextHop;
+    int16_t signalStrength;      // RSSI when last heard via this hop
+    uint16_t latencyMs;          // Smoothed ACK round trip (0 = not measured)
+    uint8_t hopCount;
+    uint8_t reliability;         // Success rate (0-100)
+    uint8_t preference;          // Static preference (0 = none, never dropped otherwise)
+};
+
+// Route Metric Policy (weights of the composite cost; lowest cost wins)
+struct RouteMetricPolicy {
+    float hopWeight;             // Per hop
+    float etxWeight;             // Per expected transmission along the path
+    float latencyWeight;         // Per second of observed ACK round trip
+    float preferenceWeight;      // Subtracted per point of static preference
+};
+
 // Routing Table Entry
 struct RoutingEntry {
-    NodeAddress destination;
-    NodeAddress nextHop;
-    NodeAddress backupHop;
+    AddressHandle destination;
+    AddressHandle nextHop;       // Primary candidate (mirrored from candidates[0])
+    AddressHandle backupHop;     // Next candidate in rank order
     uint32_t lastUsed;           // Last successful use timestamp
     uint16_t hopCount;           // Number of hops to destination
-    uint8_t signalStrength;      // RSSI of last transmission
+    int16_t signalStrength;      // RSSI of last transmission
     uint8_t reliability;         // Success rate (0-100)
     bool isValid;
+    RouteCandidate candidates[RM_ROUTE_CANDIDATES]; // Ranked best first
+    uint8_t candidateCount;
 };
 
 // Intermediary Memory Entry
 struct IntermediaryEntry {
-    NodeAddress nodeA;           // First node in connection
-    NodeAddress nodeB;           // Second node in connection
+    AddressHandle nodeA;         // First node in connection
+    AddressHandle nodeB;         // Second node in connection
     uint32_t lastBridged;        // Last time we bridged these nodes
     uint16_t bridgeCount;        // Number of times we've bridged them
     bool isActive;
@@ -137,15 +256,89 @@ struct IntermediaryEntry {
 // Subdomain Info
 struct SubdomainInfo {
     String subdomainName;
-    std::vector<NodeAddress> knownNodes;
-    std::vector<NodeAddress> stationaryHubs;
+    std::vector<AddressHandle> knownNodes;
+    std::vector<AddressHandle> stationaryHubs;
     uint32_t lastUpdated;
     bool isLocal;                // True if this is our subdomain
 };
 
+// Seen Message Cache Entry (duplicate suppression)
+struct SeenMessageEntry {
+    uint16_t sourceId;           // Originator short ID (readable without decoding addresses)
+    uint32_t messageId;          // Originator's message ID
+    uint32_t hash;               // Cached key hash (filter slot source)
+    uint32_t seenTime;           // When we first saw this message
+    uint8_t retry;               // Retry count of the copy seen (RM_ROUTE_RETRY)
+};
+
+// Scheduled Flood Rebroadcast. Overheard copies can still cancel it after
+// it is queued, and while the radio waits for a clear channel.
+enum RebroadcastStage : uint8_t {
+    REBROADCAST_WAITING = 0x00,  // In its contention slot
+    REBROADCAST_QUEUED = 0x01,   // In the transmit queue
+    REBROADCAST_SENDING = 0x02   // Taken by the radio, maybe still backing off
+};
+
+struct PendingRebroadcast {
+    PacketHandle packet;         // Relay copy (hop count and path already updated)
+    uint32_t sendTime;           // End of the contention delay, then when the radio took it
+    uint8_t copiesHeard;         // Other relays overheard meanwhile
+    RebroadcastStage stage;
+};
+
+// Route Reply Contents (MSG_ROUTE_REPLY payload)
+struct RouteReplyData {
+    uint32_t requestId;          // messageId of the answered route request
+    uint8_t hopCount;            // Replier's distance to target (0 = target itself)
+    NodeAddress target;          // Node the route leads to
+};
+
+// Pending Route Discovery
+struct PendingDiscovery {
+    uint32_t requestId;          // messageId of the latest route request
+    uint32_t requestTime;        // When the latest request was sent
+    uint8_t attempts;            // Requests sent so far
+    std::vector<PacketHandle> buffered; // Data packets waiting for the route
+};
+
+// Modulation Parameters of a Radio Profile
+struct RadioProfileParams {
+    uint8_t spreadingFactor;
+    float bandwidthKhz;
+    uint16_t preambleLength;     // Long enough for a receiver's CAD scan to catch
+    const char* name;
+};
+
+// Per-Neighbor Link State (adaptive data rate)
+struct LinkProfileEntry {
+    uint16_t shortId;            // Neighbor's short ID (0 = free slot)
+    float snr;                   // Smoothed SNR of frames heard from it
+    uint32_t lastHeard;
+    uint32_t lastMessageId;      // Last messageId we sent over this link
+    RadioProfile profile;
+};
+
+// Neighbor Link Estimate (frames heard directly from a neighbor)
+struct NeighborEntry {
+    uint16_t shortId;            // Neighbor's short ID (0 = free slot)
+    uint32_t firstHeard;
+    uint32_t lastHeard;
+    uint32_t framesHeard;
+    float rssiMean;              // EWMA of RSSI (dBm)
+    float rssiVar;               // EWMA variance of RSSI
+    float snrMean;               // EWMA of SNR (dB)
+    float snrVar;                // EWMA variance of SNR
+    uint16_t lastSequence;       // Newest sequenceNumber it originated
+    bool sequenceKnown;          // lastSequence holds a real value
+    uint16_t windowReceived;     // Frames heard in the current PRR window
+    uint16_t windowExpected;     // Frames it sent in the current PRR window
+    float prr;                   // Smoothed packet reception ratio (0-1)
+    bool prrValid;               // At least one PRR window completed
+};
+
 // Message Queue Entry
 struct QueueEntry {
-    MessagePacket packet;
+    PacketHandle packet;
     uint32_t queuedTime;
     uint8_t retryCount;
     uint32_t nextRetryTime;
@@ -168,6 +361,8 @@ struct NetworkStats {
     uint32_t messagesDropped;
     uint32_t routingTableSize;
     uint32_t lastHeartbeat;
+    uint32_t heartbeatsSuppressed;
+    uint32_t framesAggregated;   // Frames that shared another frame's preamble
     float avgRSSI;
     uint8_t networkLoad;         // 0-100 percentage
 };
@@ -176,10 +371,73 @@ struct NetworkStats {
 struct HeartbeatData {
     NodeAddress sender;
     NodeStatus status;
-    std::vector<NodeAddress> directContacts;
+    std::vector<AddressHandle> directContacts;
     std::vector<String> bridgedSubdomains;
     NetworkStats stats;
     uint32_t uptime;
 };
 
+// Heartbeat Payload Fields (presence mask, in wire order)
+enum HeartbeatField : uint8_t {
+    HB_FIELD_STATUS = 0x01,
+    HB_FIELD_UPTIME = 0x02,
+    HB_FIELD_CONTACTS = 0x04,
+    HB_FIELD_BRIDGES = 0x08,
+    HB_FIELD_SENT = 0x10,
+    HB_FIELD_RECEIVED = 0x20,
+    HB_FIELD_RSSI = 0x40,
+    HB_FIELD_LOAD = 0x80,
+    HB_FIELD_ALL = 0xFF
+};
+
+// Heartbeat Contents as sent on air (MSG_HEARTBEAT payload)
+struct HeartbeatSummary {
+    uint8_t fields;              // HeartbeatField bits present or known
+    NodeStatus status;
+    uint32_t uptimeSeconds;
+    uint16_t directContacts;
+    uint16_t bridgedSubdomains;
+    uint32_t messagesSent;
+    uint32_t messagesReceived;
+    int16_t avgRSSI;             // Whole dBm
+    uint8_t networkLoad;         // 0-100 percentage
+    uint32_t lastHeard;          // Receiver side: when the last heartbeat arrived
+};
+
+
+// Fragment Contents (MSG_FRAGMENT payload)
+struct FragmentData {
+    uint32_t messageId;          // Names the whole message (the last fragment's own messageId)
+    uint8_t index;               // 0-based position
+    uint8_t count;               // Fragments in the message
+    uint16_t offset;             // Byte offset of this fragment's data
+    const uint8_t* data;         // Points into the packet payload
+    uint8_t length;
+};
+
+// Outgoing Message Split into Fragments
+struct FragmentedMessage {
+    NodeAddress destination;
+    std::vector<uint8_t> data;   // Message as sent (compressed when that was shorter)
+    bool compressed;
+    MessagePriority priority;
+    uint16_t chunkSize;          // Data bytes per fragment
+    uint8_t count;
+    uint32_t pending;            // Bitmap of fragments still to send
+    PacketHandle lastFragment;   // Sent last; retries probe the receiver for a NACK
+    uint32_t created;
+};
+
+// Incoming Fragmented Message
+struct ReassemblyBuffer {
+    AddressHandle source;
+    uint32_t messageId;          // FragmentData::messageId
+    uint8_t count;
+    uint32_t received;           // Bitmap of fragments held
+    std::vector<uint8_t> data;
+    bool compressed;             // Fragments carried ROUTE_COMPRESSED
+    uint32_t lastUpdate;
+    bool complete;               // Delivered; kept so retried probes are re-ACKed
+};
+
 #endif // REALMESH_TYPES_H
\ No newline at end of file
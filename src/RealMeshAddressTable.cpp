@@ -0,0 +1,263 @@
+#include "RealMeshAddressTable.h"
+#include "RealMeshConfig.h"
+#include "RealMeshPacket.h"
+
+// ============================================================================
+// Node Address Intern Table Implementation
+// ============================================================================
+
+static_assert((RM_ADDRESS_TABLE_SLOTS & (RM_ADDRESS_TABLE_SLOTS - 1)) == 0,
+              "RM_ADDRESS_TABLE_SLOTS must be a power of two");
+static_assert(RM_ADDRESS_TABLE_SLOTS >= 2 * RM_MAX_ADDRESSES,
+              "RM_ADDRESS_TABLE_SLOTS must be at least twice RM_MAX_ADDRESSES");
+static_assert(RM_MAX_ADDRESSES < RM_INVALID_ADDRESS - 1,
+              "RM_MAX_ADDRESSES must fit in an AddressHandle");
+
+RealMeshAddressTable::RealMeshAddressTable() :
+    count(0),
+    deletedSlots(0),
+    nextFree(0) {
+    
+    for (size_t i = 0; i < RM_ADDRESS_TABLE_SLOTS; i++) {
+        slots[i].hash = 0;
+        slots[i].handle = SLOT_EMPTY;
+    }
+    for (size_t i = 0; i < RM_MAX_ADDRESSES; i++) {
+        entries[i].hash = 0;
+        entries[i].lastUsed = 0;
+        entries[i].inUse = false;
+        entries[i].marked = false;
+        shortIds[i] = 0;
+    }
+}
+
+AddressHandle RealMeshAddressTable::intern(const NodeAddress& address) {
+    uint32_t hash = RealMeshPacket::wireAddressHash(address);
+    
+    int slot = findSlot(hash, address);
+    if (slot >= 0) {
+        Entry& entry = entries[slots[slot].handle];
+        entry.lastUsed = millis();
+        
+        // The full address of a node known so far only by hash: same
+        // hash, same slot, so the handle and everything keyed on it stay
+        if (RealMeshPacket::isPlaceholder(entry.address) && !RealMeshPacket::isPlaceholder(address)) {
+            NodeUUID uuid = entry.address.uuid;
+            entry.address = address;
+            if (!address.uuid.isSet()) {
+                entry.address.uuid = uuid;
+            }
+            shortIds[slots[slot].handle] = entry.address.uuid.isSet() ? entry.address.uuid.getShortId() : 0;
+            return slots[slot].handle;
+        }
+        
+        // Learn the UUID once a packet carries it (user-typed addresses don't)
+        if (!entry.address.uuid.isSet() && address.uuid.isSet()) {
+            entry.address.uuid = address.uuid;
+            shortIds[slots[slot].handle] = address.uuid.getShortId();
+        }
+        return slots[slot].handle;
+    }
+    
+    if (count >= RM_MAX_ADDRESSES) {
+        return RM_INVALID_ADDRESS;
+    }
+    
+    // Find a free entry, starting from the last known hole
+    AddressHandle handle = nextFree;
+    while (entries[handle].inUse) {
+        handle = (handle + 1) % RM_MAX_ADDRESSES;
+    }
+    nextFree = (handle + 1) % RM_MAX_ADDRESSES;
+    
+    if (count + deletedSlots >= (RM_ADDRESS_TABLE_SLOTS * 3) / 4) {
+        rebuildIndex();
+    }
+    
+    uint32_t mask = RM_ADDRESS_TABLE_SLOTS - 1;
+    uint32_t pos = hash & mask;
+    while (slots[pos].handle != SLOT_EMPTY && slots[pos].handle != SLOT_DELETED) {
+        pos = (pos + 1) & mask;
+    }
+    if (slots[pos].handle == SLOT_DELETED) {
+        deletedSlots--;
+    }
+    slots[pos].hash = hash;
+    slots[pos].handle = handle;
+    
+    Entry& entry = entries[handle];
+    entry.address = address;
+    entry.hash = hash;
+    entry.lastUsed = millis();
+    entry.inUse = true;
+    entry.marked = false;
+    shortIds[handle] = address.uuid.isSet() ? address.uuid.getShortId() : 0;
+    count++;
+    
+    return handle;
+}
+
+AddressHandle RealMeshAddressTable::lookup(const NodeAddress& address) const {
+    int slot = findSlot(RealMeshPacket::wireAddressHash(address), address);
+    return slot >= 0 ? slots[slot].handle : RM_INVALID_ADDRESS;
+}
+
+AddressHandle RealMeshAddressTable::findByShortId(uint16_t shortId) const {
+    if (shortId == 0) {
+        return RM_INVALID_ADDRESS;
+    }
+    
+    for (AddressHandle i = 0; i < RM_MAX_ADDRESSES; i++) {
+        if (shortIds[i] == shortId) {
+            return i;
+        }
+    }
+    
+    return RM_INVALID_ADDRESS;
+}
+
+AddressHandle RealMeshAddressTable::findByHash(uint32_t hash) const {
+    uint32_t mask = RM_ADDRESS_TABLE_SLOTS - 1;
+    uint32_t pos = hash & mask;
+    
+    for (size_t probes = 0; probes < RM_ADDRESS_TABLE_SLOTS; probes++) {
+        const Slot& slot = slots[pos];
+        if (slot.handle == SLOT_EMPTY) {
+            break;
+        }
+        if (slot.handle != SLOT_DELETED && slot.hash == hash) {
+            return slot.handle;
+        }
+        pos = (pos + 1) & mask;
+    }
+    
+    return RM_INVALID_ADDRESS;
+}
+
+bool RealMeshAddressTable::isValid(AddressHandle handle) const {
+    return handle < RM_MAX_ADDRESSES && entries[handle].inUse;
+}
+
+const NodeAddress& RealMeshAddressTable::get(AddressHandle handle) const {
+    static const NodeAddress empty = {};
+    return isValid(handle) ? entries[handle].address : empty;
+}
+
+uint32_t RealMeshAddressTable::hashOf(AddressHandle handle) const {
+    return isValid(handle) ? entries[handle].hash : 0;
+}
+
+uint16_t RealMeshAddressTable::shortIdOf(AddressHandle handle) const {
+    return isValid(handle) ? shortIds[handle] : 0;
+}
+
+String RealMeshAddressTable::nameOf(AddressHandle handle) const {
+    return isValid(handle) ? entries[handle].address.getFullAddress() : String("?");
+}
+
+void RealMeshAddressTable::beginCollection() {
+    for (size_t i = 0; i < RM_MAX_ADDRESSES; i++) {
+        entries[i].marked = false;
+    }
+}
+
+void RealMeshAddressTable::mark(AddressHandle handle) {
+    if (isValid(handle)) {
+        entries[handle].marked = true;
+    }
+}
+
+size_t RealMeshAddressTable::sweep() {
+    uint32_t now = millis();
+    size_t freed = 0;
+    
+    for (AddressHandle i = 0; i < RM_MAX_ADDRESSES; i++) {
+        Entry& entry = entries[i];
+        if (!entry.inUse || entry.marked) continue;
+        
+        // Handles touched recently may still be held by in-flight processing
+        if (now - entry.lastUsed < RM_ADDRESS_GRACE_MS) continue;
+        
+        removeSlot(entry.hash, i);
+        entry.address = NodeAddress();
+        entry.inUse = false;
+        shortIds[i] = 0;
+        count--;
+        freed++;
+    }
+    
+    return freed;
+}
+
+// Private helpers
+
+int RealMeshAddressTable::findSlot(uint32_t hash, const NodeAddress& address) const {
+    uint32_t mask = RM_ADDRESS_TABLE_SLOTS - 1;
+    uint32_t pos = hash & mask;
+    
+    for (size_t probes = 0; probes < RM_ADDRESS_TABLE_SLOTS; probes++) {
+        const Slot& slot = slots[pos];
+        if (slot.handle == SLOT_EMPTY) {
+            return -1;
+        }
+        if (slot.handle != SLOT_DELETED && slot.hash == hash &&
+            matches(entries[slot.handle].address, address)) {
+            return (int)pos;
+        }
+        pos = (pos + 1) & mask;
+    }
+    
+    return -1;
+}
+
+bool RealMeshAddressTable::matches(const NodeAddress& known, const NodeAddress& address) {
+    if (known.sameAddress(address)) {
+        return true;
+    }
+    
+    // A placeholder matches any name with its hash, unless the short IDs
+    // show two different nodes
+    if (!RealMeshPacket::isPlaceholder(known) && !RealMeshPacket::isPlaceholder(address)) {
+        return false;
+    }
+    uint16_t knownId = known.uuid.isSet() ? known.uuid.getShortId() : 0;
+    uint16_t addressId = address.uuid.isSet() ? address.uuid.getShortId() : 0;
+    return knownId == 0 || addressId == 0 || knownId == addressId;
+}
+
+void RealMeshAddressTable::removeSlot(uint32_t hash, AddressHandle handle) {
+    uint32_t mask = RM_ADDRESS_TABLE_SLOTS - 1;
+    uint32_t pos = hash & mask;
+    
+    for (size_t probes = 0; probes < RM_ADDRESS_TABLE_SLOTS; probes++) {
+        if (slots[pos].handle == SLOT_EMPTY) {
+            return;
+        }
+        if (slots[pos].handle == handle) {
+            slots[pos].handle = SLOT_DELETED;
+            deletedSlots++;
+            return;
+        }
+        pos = (pos + 1) & mask;
+    }
+}
+
+void RealMeshAddressTable::rebuildIndex() {
+    uint32_t mask = RM_ADDRESS_TABLE_SLOTS - 1;
+    
+    for (size_t i = 0; i < RM_ADDRESS_TABLE_SLOTS; i++) {
+        slots[i].handle = SLOT_EMPTY;
+    }
+    
+    for (AddressHandle i = 0; i < RM_MAX_ADDRESSES; i++) {
+        if (!entries[i].inUse) continue;
+        uint32_t pos = entries[i].hash & mask;
+        while (slots[pos].handle != SLOT_EMPTY) {
+            pos = (pos + 1) & mask;
+        }
+        slots[pos].hash = entries[i].hash;
+        slots[pos].handle = i;
+    }
+    
+    deletedSlots = 0;
+}
@@ -0,0 +1,157 @@
+#include "RealMeshCompression.h"
+#include <string.h>
+
+// ============================================================================
+// Static-Dictionary Text Compression Implementation
+// ============================================================================
+
+static const uint8_t LETTER_BASE = 0x80;
+static const uint8_t DICTIONARY_BASE = 0xC6;
+static const uint8_t ESCAPE_BYTE = 0xFE;
+static const uint8_t ESCAPE_RUN = 0xFF;
+
+// Serbian Cyrillic (lower then upper case, azbuka order) and the Latin
+// letters with diacritics, as Unicode code points
+static const uint16_t LETTERS[] = {
+    0x0430, 0x0431, 0x0432, 0x0433, 0x0434, 0x0452, 0x0435, 0x0436, 0x0437, 0x0438,
+    0x0458, 0x043A, 0x043B, 0x0459, 0x043C, 0x043D, 0x045A, 0x043E, 0x043F, 0x0440,
+    0x0441, 0x0442, 0x045B, 0x0443, 0x0444, 0x0445, 0x0446, 0x0447, 0x045F, 0x0448,
+    0x0410, 0x0411, 0x0412, 0x0413, 0x0414, 0x0402, 0x0415, 0x0416, 0x0417, 0x0418,
+    0x0408, 0x041A, 0x041B, 0x0409, 0x041C, 0x041D, 0x040A, 0x041E, 0x041F, 0x0420,
+    0x0421, 0x0422, 0x040B, 0x0423, 0x0424, 0x0425, 0x0426, 0x0427, 0x040F, 0x0428,
+    0x010D, 0x0107, 0x017E, 0x0161, 0x0111, 0x010C, 0x0106, 0x017D, 0x0160, 0x0110
+};
+
+// Frequent fragments of Serbian (both scripts) and English chat, UTF-8.
+// Words carry their leading space so a sentence costs one byte per word.
+static const char* const DICTIONARY[] = {
+    " je", " da", " se", " na", " ne", " sam", " to", " za", " kako", " gde", " šta",
+    " li", " ali", " smo", " su", " od", " po", " pr", "hvala", "dobro", "ovo", "ije",
+    " је", " да", " се", " на", " не", " сам", " то", " за", " како", " где", " шта",
+    " ли", " али", " смо", " су", " од", " по", " пр", "хвала", "добро",
+    " the", " you", " and", " is", " for", " are", "ing", "th", "er", " ok",
+    ", ", ". ", "? ", "..."
+};
+
+static const size_t LETTER_COUNT = sizeof(LETTERS) / sizeof(LETTERS[0]);
+static const size_t DICTIONARY_COUNT = sizeof(DICTIONARY) / sizeof(DICTIONARY[0]);
+
+static_assert(LETTER_BASE + LETTER_COUNT == DICTIONARY_BASE, "Letter codes overlap the dictionary");
+static_assert(DICTIONARY_BASE + DICTIONARY_COUNT == ESCAPE_BYTE, "Dictionary codes overlap the escapes");
+
+size_t RealMeshCompression::compress(const uint8_t* in, size_t length, uint8_t* out, size_t outSize) {
+    // Only worth sending if it saves at least a byte
+    size_t limit = length > 0 ? length - 1 : 0;
+    if (outSize < limit) limit = outSize;
+    size_t pos = 0;
+    size_t written = 0;
+    
+    while (pos < length) {
+        uint8_t code;
+        size_t matched = dictionaryMatch(in + pos, length - pos, code);
+        int letter;
+        
+        if (matched > 0) {
+            if (written + 1 > limit) return 0;
+            out[written++] = code;
+            pos += matched;
+        } else if ((letter = letterCode(in + pos, length - pos)) >= 0) {
+            if (written + 1 > limit) return 0;
+            out[written++] = LETTER_BASE + letter;
+            pos += 2;
+        } else if (in[pos] < 0x80) {
+            if (written + 1 > limit) return 0;
+            out[written++] = in[pos++];
+        } else {
+            // Everything up to the next byte we can code goes out raw
+            size_t run = 1;
+            while (pos + run < length && run < 255 && in[pos + run] >= 0x80 &&
+                   letterCode(in + pos + run, length - pos - run) < 0 &&
+                   dictionaryMatch(in + pos + run, length - pos - run, code) == 0) {
+                run++;
+            }
+            
+            if (run == 1) {
+                if (written + 2 > limit) return 0;
+                out[written++] = ESCAPE_BYTE;
+                out[written++] = in[pos++];
+            } else {
+                if (written + 2 + run > limit) return 0;
+                out[written++] = ESCAPE_RUN;
+                out[written++] = run;
+                memcpy(out + written, in + pos, run);
+                written += run;
+                pos += run;
+            }
+        }
+    }
+    
+    return written;
+}
+
+size_t RealMeshCompression::decompress(const uint8_t* in, size_t length, uint8_t* out, size_t outSize) {
+    size_t pos = 0;
+    size_t written = 0;
+    
+    while (pos < length) {
+        uint8_t code = in[pos++];
+        
+        if (code < LETTER_BASE) {
+            if (written + 1 > outSize) return 0;
+            out[written++] = code;
+        } else if (code < DICTIONARY_BASE) {
+            uint16_t letter = LETTERS[code - LETTER_BASE];
+            if (written + 2 > outSize) return 0;
+            out[written++] = 0xC0 | (letter >> 6);
+            out[written++] = 0x80 | (letter & 0x3F);
+        } else if (code < ESCAPE_BYTE) {
+            const char* entry = DICTIONARY[code - DICTIONARY_BASE];
+            size_t entryLength = strlen(entry);
+            if (written + entryLength > outSize) return 0;
+            memcpy(out + written, entry, entryLength);
+            written += entryLength;
+        } else {
+            size_t run = 1;
+            if (code == ESCAPE_RUN) {
+                if (pos >= length) return 0;
+                run = in[pos++];
+            }
+            if (pos + run > length || written + run > outSize) return 0;
+            memcpy(out + written, in + pos, run);
+            written += run;
+            pos += run;
+        }
+    }
+    
+    return written;
+}
+
+// Private methods
+
+int RealMeshCompression::letterCode(const uint8_t* in, size_t remaining) {
+    // Two-byte UTF-8 sequences only
+    if (remaining < 2 || (in[0] & 0xE0) != 0xC0 || (in[1] & 0xC0) != 0x80) {
+        return -1;
+    }
+    
+    uint16_t codePoint = ((in[0] & 0x1F) << 6) | (in[1] & 0x3F);
+    for (size_t i = 0; i < LETTER_COUNT; i++) {
+        if (LETTERS[i] == codePoint) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+size_t RealMeshCompression::dictionaryMatch(const uint8_t* in, size_t remaining, uint8_t& code) {
+    // Longest entry wins; ties go to the earlier one
+    size_t best = 0;
+    for (size_t i = 0; i < DICTIONARY_COUNT; i++) {
+        size_t entryLength = strlen(DICTIONARY[i]);
+        if (entryLength > best && entryLength <= remaining && memcmp(in, DICTIONARY[i], entryLength) == 0) {
+            best = entryLength;
+            code = DICTIONARY_BASE + i;
+        }
+    }
+    return best;
+}
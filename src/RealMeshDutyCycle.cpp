@@ -0,0 +1,106 @@
+#include "RealMeshDutyCycle.h"
+#include "RealMeshConfig.h"
+
+// ============================================================================
+// EU868 Duty-Cycle Ledger Implementation
+// ============================================================================
+
+static const uint32_t BUCKET_MS = RM_DUTY_CYCLE_WINDOW_MS / RM_DUTY_CYCLE_BUCKETS;
+
+// ETSI EN 300 220 sub-bands (start MHz, end MHz, duty cycle in permille)
+static const struct {
+    float startMhz;
+    float endMhz;
+    uint16_t permille;
+} SUBBANDS[] = {
+    {863.0f, 868.0f,  10},   // g   1%
+    {868.0f, 868.6f,  10},   // g1  1%
+    {868.7f, 869.2f,   1},   // g2  0.1%
+    {869.4f, 869.65f, 100},  // g3  10%
+    {869.7f, 870.0f,  10},   // g4  1%
+};
+
+RealMeshDutyCycle::RealMeshDutyCycle() :
+    currentEpoch(0),
+    subBand(0) {
+    
+    memset(airtime, 0, sizeof(airtime));
+    currentEpoch = millis() / BUCKET_MS;
+    setFrequency(RM_FREQ_MHZ);
+}
+
+void RealMeshDutyCycle::setFrequency(float freqMhz) {
+    subBand = subBandFor(freqMhz);
+}
+
+bool RealMeshDutyCycle::canTransmit(uint32_t airtimeMs, uint8_t priority) {
+    uint32_t allowed = getBudget() / 100 * sharePercent(priority);
+    
+    return getUsedAirtime() + airtimeMs <= allowed;
+}
+
+void RealMeshDutyCycle::recordTransmission(uint32_t airtimeMs) {
+    advance();
+    airtime[subBand][currentEpoch % RM_DUTY_CYCLE_BUCKETS] += airtimeMs;
+}
+
+uint32_t RealMeshDutyCycle::getUsedAirtime() {
+    advance();
+    
+    uint32_t used = 0;
+    for (uint8_t i = 0; i < RM_DUTY_CYCLE_BUCKETS; i++) {
+        used += airtime[subBand][i];
+    }
+    return used;
+}
+
+uint32_t RealMeshDutyCycle::getBudget() const {
+    return (uint32_t)RM_DUTY_CYCLE_WINDOW_MS / 1000 * dutyPermille(subBand);
+}
+
+uint8_t RealMeshDutyCycle::getUsagePercent() {
+    uint32_t budget = getBudget();
+    if (budget == 0) return 100;
+    
+    return (uint8_t)min((uint32_t)100, getUsedAirtime() * 100 / budget);
+}
+
+// Private methods
+
+void RealMeshDutyCycle::advance() {
+    uint32_t epoch = millis() / BUCKET_MS;
+    
+    // Clear every bucket that slid out of the window since the last call
+    uint32_t elapsed = min(epoch - currentEpoch, (uint32_t)RM_DUTY_CYCLE_BUCKETS);
+    for (uint32_t i = 1; i <= elapsed; i++) {
+        uint8_t bucket = (currentEpoch + i) % RM_DUTY_CYCLE_BUCKETS;
+        for (uint8_t band = 0; band < SUBBAND_COUNT; band++) {
+            airtime[band][bucket] = 0;
+        }
+    }
+    
+    currentEpoch = epoch;
+}
+
+uint8_t RealMeshDutyCycle::subBandFor(float freqMhz) {
+    for (uint8_t i = 0; i < SUBBAND_COUNT - 1; i++) {
+        if (freqMhz >= SUBBANDS[i].startMhz && freqMhz < SUBBANDS[i].endMhz) {
+            return i;
+        }
+    }
+    return SUBBAND_COUNT - 1;
+}
+
+uint16_t RealMeshDutyCycle::dutyPermille(uint8_t band) {
+    // Outside the listed sub-bands, hold ourselves to the common 1%
+    return band < SUBBAND_COUNT - 1 ? SUBBANDS[band].permille : 10;
+}
+
+uint8_t RealMeshDutyCycle::sharePercent(uint8_t priority) {
+    switch (priority) {
+        case PRIORITY_EMERGENCY: return 100;
+        case PRIORITY_DIRECT:    return RM_DUTY_SHARE_DIRECT;
+        case PRIORITY_PUBLIC:    return RM_DUTY_SHARE_PUBLIC;
+        default:                 return RM_DUTY_SHARE_CONTROL;
+    }
+}
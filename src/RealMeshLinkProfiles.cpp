@@ -0,0 +1,199 @@
+#include "RealMeshLinkProfiles.h"
+#include "RealMeshAirtime.h"
+#include "RealMeshConfig.h"
+
+// ============================================================================
+// Per-Neighbor Radio Profiles Implementation
+// ============================================================================
+
+// SLOW is listed with the preamble of nodes that don't scan
+static const RadioProfileParams PROFILES[PROFILE_COUNT] = {
+    {RM_PROFILE_FAST_SF,   RM_PROFILE_FAST_BW_KHZ,   RM_PROFILE_FAST_PREAMBLE,   "FAST"},
+    {RM_PROFILE_MEDIUM_SF, RM_PROFILE_MEDIUM_BW_KHZ, RM_PROFILE_MEDIUM_PREAMBLE, "MEDIUM"},
+    {RM_SPREADING_FACTOR,  RM_BANDWIDTH_KHZ,         RM_PREAMBLE_LENGTH,         "SLOW"},
+};
+
+// A scanning receiver cycles CAD over the control profile and at most both
+// faster ones. A preamble that starts just after its CAD is only caught on
+// the next cycle, and must then still have the symbols the receiver needs
+// to lock on.
+static constexpr uint32_t SCAN_CYCLE_US = RM_ADR_CAD_SYMBOLS * (
+    RealMeshAirtime::symbolTimeUs(RM_PROFILE_FAST_SF, RM_PROFILE_FAST_BW_KHZ) +
+    RealMeshAirtime::symbolTimeUs(RM_PROFILE_MEDIUM_SF, RM_PROFILE_MEDIUM_BW_KHZ) +
+    RealMeshAirtime::symbolTimeUs(RM_SPREADING_FACTOR, RM_BANDWIDTH_KHZ));
+
+static constexpr bool preambleOutlastsScan(uint32_t preamble, uint8_t sf, float bwKhz) {
+    return preamble * RealMeshAirtime::symbolTimeUs(sf, bwKhz) >=
+           2 * SCAN_CYCLE_US + RM_ADR_SYNC_SYMBOLS * RealMeshAirtime::symbolTimeUs(sf, bwKhz);
+}
+
+static_assert(preambleOutlastsScan(RM_PROFILE_FAST_PREAMBLE, RM_PROFILE_FAST_SF, RM_PROFILE_FAST_BW_KHZ),
+              "RM_PROFILE_FAST_PREAMBLE is shorter than two CAD scan cycles plus sync");
+static_assert(preambleOutlastsScan(RM_PROFILE_MEDIUM_PREAMBLE, RM_PROFILE_MEDIUM_SF, RM_PROFILE_MEDIUM_BW_KHZ),
+              "RM_PROFILE_MEDIUM_PREAMBLE is shorter than two CAD scan cycles plus sync");
+static_assert(preambleOutlastsScan(RM_PROFILE_SLOW_PREAMBLE, RM_SPREADING_FACTOR, RM_BANDWIDTH_KHZ),
+              "RM_PROFILE_SLOW_PREAMBLE is shorter than two CAD scan cycles plus sync");
+
+RealMeshLinkProfiles::RealMeshLinkProfiles() {
+    memset(links, 0, sizeof(links));
+}
+
+void RealMeshLinkProfiles::recordReception(uint16_t shortId, float snr) {
+    if (shortId == 0) return;
+    
+    LinkProfileEntry* link = find(shortId);
+    if (!link) {
+        link = allocate(shortId);
+        link->snr = snr;
+        link->profile = PROFILE_SLOW;
+    } else {
+        link->snr = (link->snr * 0.75f) + (snr * 0.25f);
+    }
+    link->lastHeard = millis();
+    
+    RadioProfile profile = selectProfile(link->snr, link->profile);
+    if (profile != link->profile) {
+        Serial.printf("[RADIO] Link %04X: %s -> %s (SNR %.1f dB)\n", shortId,
+                     params(link->profile).name, params(profile).name, link->snr);
+        link->profile = profile;
+    }
+}
+
+RadioProfile RealMeshLinkProfiles::profileFor(uint16_t shortId, uint32_t messageId) const {
+    if (!RM_ADR_ENABLED || shortId == 0) {
+        return PROFILE_SLOW;
+    }
+    
+    const LinkProfileEntry* link = find(shortId);
+    if (!link || millis() - link->lastHeard > RM_ADR_LINK_TIMEOUT) {
+        return PROFILE_SLOW;
+    }
+    
+    if (messageId != 0 && messageId == link->lastMessageId && link->profile != PROFILE_SLOW) {
+        return (RadioProfile)(link->profile + 1);
+    }
+    
+    return link->profile;
+}
+
+bool RealMeshLinkProfiles::inUse(RadioProfile profile) const {
+    if (!RM_ADR_ENABLED) {
+        return profile == PROFILE_SLOW;
+    }
+    
+    for (size_t i = 0; i < RM_ADR_MAX_LINKS; i++) {
+        const LinkProfileEntry& link = links[i];
+        if (link.shortId != 0 && link.profile == profile && millis() - link.lastHeard <= RM_ADR_LINK_TIMEOUT) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool RealMeshLinkProfiles::needsScan() const {
+    return inUse(PROFILE_FAST) || inUse(PROFILE_MEDIUM);
+}
+
+void RealMeshLinkProfiles::recordTransmission(uint16_t shortId, uint32_t messageId, RadioProfile profile) {
+    LinkProfileEntry* link = find(shortId);
+    if (!link) return;
+    
+    if (profile > link->profile) {
+        Serial.printf("[RADIO] Link %04X: resend, stepping down to %s\n", shortId, params(profile).name);
+        link->profile = profile;
+    }
+    link->lastMessageId = messageId;
+}
+
+size_t RealMeshLinkProfiles::getLinkCount() const {
+    size_t count = 0;
+    for (size_t i = 0; i < RM_ADR_MAX_LINKS; i++) {
+        if (links[i].shortId != 0) count++;
+    }
+    return count;
+}
+
+void RealMeshLinkProfiles::printLinks() const {
+    Serial.printf("[RADIO] Link profiles (%d):\n", getLinkCount());
+    for (size_t i = 0; i < RM_ADR_MAX_LINKS; i++) {
+        const LinkProfileEntry& link = links[i];
+        if (link.shortId == 0) continue;
+        
+        Serial.printf("  %04X: %s, SNR %.1f dB, heard %us ago\n", link.shortId,
+                     params(profileFor(link.shortId)).name, link.snr, (unsigned)((millis() - link.lastHeard) / 1000));
+    }
+}
+
+const RadioProfileParams& RealMeshLinkProfiles::params(RadioProfile profile) {
+    return PROFILES[profile < PROFILE_COUNT ? profile : PROFILE_SLOW];
+}
+
+uint16_t RealMeshLinkProfiles::preambleLength(RadioProfile profile, bool scanning) {
+    return scanning && profile == PROFILE_SLOW ? RM_PROFILE_SLOW_PREAMBLE : params(profile).preambleLength;
+}
+
+uint32_t RealMeshLinkProfiles::airtimeMs(RadioProfile profile, size_t bytes, bool scanning) {
+    const RadioProfileParams& p = params(profile);
+    return RealMeshAirtime::timeOnAirMs(bytes, p.spreadingFactor, p.bandwidthKhz, RM_CODING_RATE,
+                                        preambleLength(profile, scanning));
+}
+
+// Private methods
+
+LinkProfileEntry* RealMeshLinkProfiles::find(uint16_t shortId) {
+    if (shortId == 0) return nullptr; // Marks free slots
+    
+    for (size_t i = 0; i < RM_ADR_MAX_LINKS; i++) {
+        if (links[i].shortId == shortId) return &links[i];
+    }
+    return nullptr;
+}
+
+const LinkProfileEntry* RealMeshLinkProfiles::find(uint16_t shortId) const {
+    if (shortId == 0) return nullptr;
+    
+    for (size_t i = 0; i < RM_ADR_MAX_LINKS; i++) {
+        if (links[i].shortId == shortId) return &links[i];
+    }
+    return nullptr;
+}
+
+LinkProfileEntry* RealMeshLinkProfiles::allocate(uint16_t shortId) {
+    // Take a free slot, otherwise the neighbor heard from least recently
+    LinkProfileEntry* slot = &links[0];
+    for (size_t i = 0; i < RM_ADR_MAX_LINKS; i++) {
+        if (links[i].shortId == 0) {
+            slot = &links[i];
+            break;
+        }
+        if (millis() - links[i].lastHeard > millis() - slot->lastHeard) {
+            slot = &links[i];
+        }
+    }
+    
+    memset(slot, 0, sizeof(LinkProfileEntry));
+    slot->shortId = shortId;
+    return slot;
+}
+
+RadioProfile RealMeshLinkProfiles::selectProfile(float snr, RadioProfile current) {
+    // Fastest profile with enough margin; moving faster needs extra
+    // margin so a link near a threshold doesn't flap between profiles
+    for (uint8_t p = PROFILE_FAST; p < PROFILE_SLOW; p++) {
+        float required = demodulationFloor(PROFILES[p].spreadingFactor) + RM_ADR_MARGIN_DB;
+        if (p < current) {
+            required += RM_ADR_HYSTERESIS_DB;
+        }
+        
+        if (snr >= required) {
+            return (RadioProfile)p;
+        }
+    }
+    
+    return PROFILE_SLOW;
+}
+
+float RealMeshLinkProfiles::demodulationFloor(uint8_t spreadingFactor) {
+    // SX126x: -7.5 dB at SF7, 2.5 dB lower per step
+    return -7.5f - 2.5f * ((int)spreadingFactor - 7);
+}
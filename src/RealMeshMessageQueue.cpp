@@ -0,0 +1,198 @@
+#include "RealMeshMessageQueue.h"
+#include "RealMeshConfig.h"
+#include <algorithm>
+
+// ============================================================================
+// Per-Priority Transmit Queues Implementation
+// ============================================================================
+
+RealMeshMessageQueue::RealMeshMessageQueue() :
+    dropped(0) {
+}
+
+bool RealMeshMessageQueue::enqueue(const PacketHandle& packet, uint8_t networkLoad) {
+    // Same message already waiting (retry, or a second relay path)
+    if (!packet || isQueued(*packet)) {
+        dropped++;
+        return false;
+    }
+    
+    uint8_t index = queueIndex(packet->header.priority);
+    std::deque<QueueEntry>& queue = queues[index];
+    size_t capacity = capacityOf(index, networkLoad);
+    
+    while (queue.size() >= capacity) {
+        if (index == PRIORITY_EMERGENCY || index == PRIORITY_CONTROL) {
+            // These queues keep what they already accepted
+            dropped++;
+            return false;
+        }
+        
+        // Direct and public: newest traffic wins, evict the oldest
+        queue.pop_front();
+        dropped++;
+    }
+    
+    QueueEntry entry;
+    entry.packet = packet;
+    entry.queuedTime = millis();
+    entry.retryCount = 0;
+    entry.nextRetryTime = 0;
+    entry.priority = (MessagePriority)index;
+    queue.push_back(entry);
+    return true;
+}
+
+QueueEntry* RealMeshMessageQueue::peek(uint8_t networkLoad,
+                                       const std::function<bool(const QueueEntry&)>& skip) {
+    uint32_t now = millis();
+    
+    for (uint8_t i = 0; i < QUEUE_COUNT; i++) {
+        if (queues[i].empty()) {
+            continue;
+        }
+        
+        // Control traffic yields to a busy channel, but only for so long
+        if (i == PRIORITY_CONTROL && networkLoad >= RM_CONGESTION_THRESHOLD &&
+            now - queues[i].front().queuedTime < RM_QUEUE_CONTROL_MAX_DEFER) {
+            continue;
+        }
+        
+        for (QueueEntry& entry : queues[i]) {
+            if (!skip || !skip(entry)) {
+                return &entry;
+            }
+        }
+    }
+    
+    return nullptr;
+}
+
+void RealMeshMessageQueue::pop(const QueueEntry* entry) {
+    if (!entry) {
+        return;
+    }
+    
+    std::deque<QueueEntry>& queue = queues[queueIndex(entry->priority)];
+    if (!queue.empty() && &queue.front() == entry) {
+        queue.pop_front();
+        return;
+    }
+    
+    // Sent from behind a held entry
+    for (auto it = queue.begin(); it != queue.end(); ++it) {
+        if (&*it == entry) {
+            queue.erase(it);
+            return;
+        }
+    }
+}
+
+size_t RealMeshMessageQueue::expire(uint8_t networkLoad) {
+    uint32_t now = millis();
+    size_t evicted = 0;
+    
+    for (uint8_t i = 0; i < QUEUE_COUNT; i++) {
+        uint32_t maxAge = maxAgeOf(i, networkLoad);
+        if (maxAge == 0) {
+            continue;
+        }
+        
+        // FIFO order means the oldest entries are always at the front
+        while (!queues[i].empty() && now - queues[i].front().queuedTime > maxAge) {
+            queues[i].pop_front();
+            evicted++;
+        }
+    }
+    
+    dropped += evicted;
+    return evicted;
+}
+
+void RealMeshMessageQueue::forEach(const std::function<void(const QueueEntry&)>& visit) const {
+    for (uint8_t i = 0; i < QUEUE_COUNT; i++) {
+        for (const QueueEntry& entry : queues[i]) {
+            visit(entry);
+        }
+    }
+}
+
+void RealMeshMessageQueue::remove(const std::vector<const QueueEntry*>& entries) {
+    for (uint8_t i = 0; i < QUEUE_COUNT; i++) {
+        std::deque<QueueEntry>& queue = queues[i];
+        
+        // Match by address before erasing anything, then erase back to
+        // front so the remaining indices stay valid
+        std::vector<size_t> indices;
+        for (size_t j = 0; j < queue.size(); j++) {
+            if (std::find(entries.begin(), entries.end(), &queue[j]) != entries.end()) {
+                indices.push_back(j);
+            }
+        }
+        
+        for (size_t j = indices.size(); j-- > 0;) {
+            queue.erase(queue.begin() + indices[j]);
+        }
+    }
+}
+
+size_t RealMeshMessageQueue::size() const {
+    size_t total = 0;
+    for (uint8_t i = 0; i < QUEUE_COUNT; i++) {
+        total += queues[i].size();
+    }
+    return total;
+}
+
+size_t RealMeshMessageQueue::size(MessagePriority priority) const {
+    return queues[queueIndex(priority)].size();
+}
+
+// Private methods
+
+uint8_t RealMeshMessageQueue::queueIndex(uint8_t priority) {
+    // Unknown priorities are treated as control traffic
+    return priority < QUEUE_COUNT ? priority : PRIORITY_CONTROL;
+}
+
+size_t RealMeshMessageQueue::capacityOf(uint8_t queue, uint8_t networkLoad) {
+    switch (queue) {
+        case PRIORITY_EMERGENCY:
+            return RM_QUEUE_EMERGENCY_SIZE;
+        case PRIORITY_DIRECT:
+            return RM_QUEUE_DIRECT_SIZE;
+        case PRIORITY_PUBLIC: {
+            // Shrink toward a single slot as the channel fills up
+            size_t capacity = RM_QUEUE_PUBLIC_SIZE - (RM_QUEUE_PUBLIC_SIZE * min(networkLoad, (uint8_t)100)) / 100;
+            return max((size_t)1, capacity);
+        }
+        default:
+            return RM_QUEUE_CONTROL_SIZE;
+    }
+}
+
+uint32_t RealMeshMessageQueue::maxAgeOf(uint8_t queue, uint8_t networkLoad) {
+    switch (queue) {
+        case PRIORITY_DIRECT:
+            return RM_QUEUE_DIRECT_MAX_AGE;
+        case PRIORITY_PUBLIC: {
+            uint32_t maxAge = (uint32_t)RM_QUEUE_PUBLIC_MAX_AGE * (100 - min(networkLoad, (uint8_t)100)) / 100;
+            return max((uint32_t)1000, maxAge);
+        }
+        default:
+            return 0; // Emergency and control never age out
+    }
+}
+
+bool RealMeshMessageQueue::isQueued(const MessagePacket& packet) const {
+    for (uint8_t i = 0; i < QUEUE_COUNT; i++) {
+        for (const QueueEntry& entry : queues[i]) {
+            if (entry.packet->header.messageId == packet.header.messageId &&
+                entry.packet->source.uuid == packet.source.uuid &&
+                entry.packet->header.messageType == packet.header.messageType) {
+                return true;
+            }
+        }
+    }
+    return false;
+}
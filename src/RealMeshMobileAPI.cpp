@@ -301,7 +301,15 @@ String RealMeshAPI::sendMessage(const String& address, const String& message) {
     bool success = meshNode->sendMessage(address, message);
     if (success) {
         String info = (address == "svet" || address == "@") ? " to public channel" : " to " + address;
-        return createResponse(true, "Message sent" + info);
+        
+        // messageId lets the app match later delivery notifications
+        DynamicJsonDocument doc(256);
+        doc["status"] = "Message sent" + info;
+        doc["messageId"] = meshNode->getLastMessageId();
+        
+        String result;
+        serializeJson(doc, result);
+        return createResponse(true, result);
     } else {
         return createResponse(false, "", "Failed to send message");
     }
@@ -511,4 +519,26 @@ void RealMeshAPI::notifyMessageReceived(const String& from, const String& messag
     bleCharacteristic->notify();
     
     Serial.printf("📱 Notified mobile app: Message from %s\n", from.c_str());
+}
+
+void RealMeshAPI::notifyDeliveryStatus(uint32_t messageId, const String& to, DeliveryStatus status) {
+    if (!bleEnabled || !bleCharacteristic) {
+        return;
+    }
+    
+    // Create notification JSON
+    DynamicJsonDocument doc(256);
+    doc["type"] = "delivery";
+    doc["messageId"] = messageId;
+    doc["to"] = to;
+    doc["status"] = status == DELIVERY_ACKED ? "delivered" :
+                    status == DELIVERY_FAILED ? "failed" : "pending";
+    doc["timestamp"] = millis() / 1000;
+    
+    String notification;
+    serializeJson(doc, notification);
+    
+    // Send as BLE notification
+    bleCharacteristic->setValue(notification.c_str());
+    bleCharacteristic->notify();
 }
\ No newline at end of file
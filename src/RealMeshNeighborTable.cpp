@@ -0,0 +1,153 @@
+#include "RealMeshNeighborTable.h"
+#include "RealMeshConfig.h"
+
+// ============================================================================
+// Neighbor Table and Link Estimator Implementation
+// ============================================================================
+
+RealMeshNeighborTable::RealMeshNeighborTable() {
+    memset(entries, 0, sizeof(entries));
+}
+
+bool RealMeshNeighborTable::recordFrame(uint16_t shortId, int16_t rssi, float snr, bool originated, uint16_t sequence) {
+    if (shortId == 0) return false;
+    
+    NeighborEntry* entry = findSlot(shortId);
+    bool isNew = !entry || !isActive(*entry);
+    if (!entry) {
+        entry = allocate(shortId);
+        entry->rssiMean = rssi;
+        entry->snrMean = snr;
+        Serial.printf("[ROUTER] New neighbor %04X (RSSI: %d, SNR: %.1f)\n", shortId, rssi, snr);
+    } else {
+        updateEwma(entry->rssiMean, entry->rssiVar, rssi);
+        updateEwma(entry->snrMean, entry->snrVar, snr);
+    }
+    
+    if (originated) {
+        updateReceptionRatio(*entry, sequence);
+    }
+    
+    entry->framesHeard++;
+    entry->lastHeard = millis();
+    return isNew;
+}
+
+const NeighborEntry* RealMeshNeighborTable::find(uint16_t shortId) const {
+    if (shortId == 0) return nullptr;
+    
+    for (size_t i = 0; i < RM_MAX_NEIGHBORS; i++) {
+        if (entries[i].shortId == shortId) {
+            return isActive(entries[i]) ? &entries[i] : nullptr;
+        }
+    }
+    return nullptr;
+}
+
+float RealMeshNeighborTable::getPrr(uint16_t shortId) const {
+    const NeighborEntry* entry = find(shortId);
+    return entry ? prrOf(*entry) : 0.0f;
+}
+
+float RealMeshNeighborTable::getEtx(uint16_t shortId) const {
+    float prr = getPrr(shortId);
+    float etx = prr > 0.0f ? 1.0f / (prr * prr) : RM_NEIGHBOR_MAX_ETX;
+    return min(etx, RM_NEIGHBOR_MAX_ETX);
+}
+
+size_t RealMeshNeighborTable::size() const {
+    size_t count = 0;
+    for (size_t i = 0; i < RM_MAX_NEIGHBORS; i++) {
+        if (isActive(entries[i])) count++;
+    }
+    return count;
+}
+
+void RealMeshNeighborTable::print() const {
+    Serial.printf("[ROUTER] Neighbors (%d):\n", size());
+    for (size_t i = 0; i < RM_MAX_NEIGHBORS; i++) {
+        const NeighborEntry& entry = entries[i];
+        if (!isActive(entry)) continue;
+        
+        Serial.printf("  %04X: rssi %.1f (sd %.1f) dBm, snr %.1f (sd %.1f) dB, prr %.2f, etx %.2f, heard %us ago\n",
+                     entry.shortId,
+                     entry.rssiMean, sqrtf(entry.rssiVar),
+                     entry.snrMean, sqrtf(entry.snrVar),
+                     prrOf(entry), getEtx(entry.shortId),
+                     (unsigned)((millis() - entry.lastHeard) / 1000));
+    }
+}
+
+// Private methods
+
+NeighborEntry* RealMeshNeighborTable::findSlot(uint16_t shortId) {
+    for (size_t i = 0; i < RM_MAX_NEIGHBORS; i++) {
+        if (entries[i].shortId == shortId) return &entries[i];
+    }
+    return nullptr;
+}
+
+NeighborEntry* RealMeshNeighborTable::allocate(uint16_t shortId) {
+    // Take a free slot, otherwise the neighbor heard from least recently
+    NeighborEntry* slot = &entries[0];
+    for (size_t i = 0; i < RM_MAX_NEIGHBORS; i++) {
+        if (entries[i].shortId == 0) {
+            slot = &entries[i];
+            break;
+        }
+        if (millis() - entries[i].lastHeard > millis() - slot->lastHeard) {
+            slot = &entries[i];
+        }
+    }
+    
+    memset(slot, 0, sizeof(NeighborEntry));
+    slot->shortId = shortId;
+    slot->firstHeard = millis();
+    return slot;
+}
+
+void RealMeshNeighborTable::updateReceptionRatio(NeighborEntry& entry, uint16_t sequence) {
+    int16_t delta = (int16_t)(sequence - entry.lastSequence);
+    
+    // Retries and late copies repeat or predate what we've already counted
+    if (entry.sequenceKnown && delta <= 0 && delta > -RM_NEIGHBOR_MAX_SEQ_GAP) {
+        return;
+    }
+    
+    // First originated frame, a restart (counter reset) or a long silence:
+    // start counting here without charging the jump as losses
+    if (!entry.sequenceKnown || delta < 0 || delta > RM_NEIGHBOR_MAX_SEQ_GAP) {
+        delta = 1;
+        entry.sequenceKnown = true;
+    }
+    
+    entry.lastSequence = sequence;
+    entry.windowReceived++;
+    entry.windowExpected += delta;
+    
+    if (entry.windowExpected >= RM_NEIGHBOR_PRR_WINDOW) {
+        float sample = (float)entry.windowReceived / entry.windowExpected;
+        entry.prr = entry.prrValid ? (entry.prr * (1.0f - RM_NEIGHBOR_PRR_ALPHA)) + (sample * RM_NEIGHBOR_PRR_ALPHA)
+                                   : sample;
+        entry.prrValid = true;
+        entry.windowReceived = 0;
+        entry.windowExpected = 0;
+    }
+}
+
+float RealMeshNeighborTable::prrOf(const NeighborEntry& entry) {
+    // Until a window completes, use what the partial window shows
+    if (entry.prrValid) return entry.prr;
+    if (entry.windowExpected > 0) return (float)entry.windowReceived / entry.windowExpected;
+    return 1.0f; // Only heard relaying so far - no evidence of loss
+}
+
+bool RealMeshNeighborTable::isActive(const NeighborEntry& entry) {
+    return entry.shortId != 0 && millis() - entry.lastHeard <= RM_NEIGHBOR_TIMEOUT;
+}
+
+void RealMeshNeighborTable::updateEwma(float& mean, float& var, float sample) {
+    float diff = sample - mean;
+    mean += RM_NEIGHBOR_EWMA_ALPHA * diff;
+    var = (1.0f - RM_NEIGHBOR_EWMA_ALPHA) * (var + RM_NEIGHBOR_EWMA_ALPHA * diff * diff);
+}
@@ -37,7 +37,8 @@ RealMeshNode::RealMeshNode() :
     verboseLogging(false),
     messageReceivedCallback(nullptr),
     networkEventCallback(nullptr),
-    stateChangedCallback(nullptr) {
+    stateChangedCallback(nullptr),
+    deliveryStatusCallback(nullptr) {
     
     nodeStartTime = millis();
 }
@@ -122,8 +123,8 @@ bool RealMeshNode::begin(const String& desiredNodeId, const String& desiredSubdo
     }
     
     // Set radio callbacks
-    radio->setOnMessageReceived([this](const MessagePacket& packet, int16_t rssi, float snr) {
-        this->onRadioMessageReceived(packet, rssi, snr);
+    radio->setOnMessageReceived([this](const RealMeshPacketView& frame, int16_t rssi, float snr) {
+        this->onRadioMessageReceived(frame, rssi, snr);
     });
     radio->setOnTransmitComplete([this](bool success, const String& error) {
         this->onRadioTransmitComplete(success, error);
@@ -149,6 +150,21 @@ bool RealMeshNode::begin(const String& desiredNodeId, const String& desiredSubdo
             this->onRouteUpdate(update);
         }
     );
+    router->setDeliveryCallback([this](uint32_t messageId, const NodeAddress& destination, DeliveryStatus status) {
+        this->onDeliveryStatus(messageId, destination, status);
+    });
+    router->setCanSendCallback([this](const MessagePacket& packet) -> bool {
+        return radio->canTransmit(packet);
+    });
+    router->setAirtimeCallback([this](uint16_t nextHop, size_t bytes) -> uint32_t {
+        return radio->getAirtimeMs(nextHop, bytes);
+    });
+    router->setReassembledCallback([this](const NodeAddress& source, const String& message) {
+        this->onReassembledMessage(source, message);
+    });
+    router->setCancelSendCallback([this](uint16_t sourceShortId, uint32_t messageId) -> bool {
+        return radio->cancelTransmit(sourceShortId, messageId);
+    });
     
     // Start network discovery
     startNetworkDiscovery();
@@ -165,6 +181,14 @@ void RealMeshNode::loop() {
         radio->processIncoming();
     }
     
+    // Route discovery retries and timeouts
+    if (router) {
+        if (radio) {
+            router->setNetworkLoad((uint8_t)radio->getChannelUtilization());
+        }
+        router->loop();
+    }
+    
     // Handle state-specific processing
     switch (currentState) {
         case STATE_NAME_CONFLICT:
@@ -580,8 +604,8 @@ void RealMeshNode::startNetworkDiscovery() {
 void RealMeshNode::broadcastPresence() {
     if (!router) return;
     
-    // Send heartbeat to announce our presence
-    router->sendHeartbeat();
+    // Shorten the heartbeat interval so our presence is announced soon
+    router->resetHeartbeatTimer("presence announcement");
     lastDiscoveryBroadcast = millis();
     
     logEvent("INFO", "Broadcasted presence announcement");
@@ -635,23 +659,25 @@ void RealMeshNode::handleStateTransition(NodeState oldState, NodeState newState)
     }
 }
 
-void RealMeshNode::onRadioMessageReceived(const MessagePacket& packet, int16_t rssi, float snr) {
+void RealMeshNode::onRadioMessageReceived(const RealMeshPacketView& frame, int16_t rssi, float snr) {
     if (verboseLogging) {
-        logEvent("DEBUG", "Radio received: " + RealMeshPacket::packetToString(packet));
+        logEvent("DEBUG", "Radio received: ID " + String(frame.header().messageId, HEX) +
+                 " type " + String(frame.header().messageType) + " (" + String(frame.length()) + " bytes)");
     }
     
     // Handle name conflict messages directly
-    if (packet.header.messageType == MSG_NAME_CONFLICT && 
-        packet.destination.getFullAddress() == ownAddress.getFullAddress()) {
-        
-        logEvent("WARNING", "Name conflict detected from " + packet.source.getFullAddress());
-        startNameConflictResolution();
+    if (frame.header().messageType == MSG_NAME_CONFLICT && frame.isAddressedTo(ownAddress)) {
+        MessagePacket packet;
+        if (frame.decode(packet)) {
+            logEvent("WARNING", "Name conflict detected from " + packet.source.getFullAddress());
+            startNameConflictResolution();
+        }
         return;
     }
     
     // Pass to router for processing
     if (router) {
-        router->processIncomingPacket(packet, rssi, snr);
+        router->processIncomingFrame(frame, rssi, snr);
     }
 }
 
@@ -662,12 +688,28 @@ void RealMeshNode::onRouterMessageForUs(const MessagePacket& packet) {
     }
 }
 
+void RealMeshNode::onReassembledMessage(const NodeAddress& source, const String& message) {
+    if (messageReceivedCallback) {
+        messageReceivedCallback(source.getFullAddress(), message);
+    }
+}
+
 void RealMeshNode::onRouteUpdate(const String& update) {
     if (networkEventCallback) {
         networkEventCallback("ROUTE_UPDATE", update);
     }
 }
 
+void RealMeshNode::onDeliveryStatus(uint32_t messageId, const NodeAddress& destination, DeliveryStatus status) {
+    if (status == DELIVERY_FAILED) {
+        logEvent("WARN", "Message to " + destination.getFullAddress() + " was not acknowledged");
+    }
+    
+    if (deliveryStatusCallback) {
+        deliveryStatusCallback(messageId, destination.getFullAddress(), status);
+    }
+}
+
 void RealMeshNode::runPeriodicMaintenance() {
     updateNodeStatistics();
     cleanupOldData();
@@ -724,9 +766,12 @@ void RealMeshNode::printNetworkInfo() {
         Serial.printf("Routing entries: %d\n", router->getRoutingTableSize());
         Serial.printf("Known subdomains: %d\n", router->getSubdomainCount());
         Serial.printf("Intermediary bridges: %d\n", router->getIntermediaryCount());
+        Serial.printf("Neighbors: %d\n", router->getNeighborCount());
         
         // Print routing table
         router->printRoutingTable();
+        router->printNeighborTable();
+        router->printHeartbeats();
         
         // Print subdomain info
         router->printSubdomainInfo();
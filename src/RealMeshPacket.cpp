@@ -1,6 +1,8 @@
 #include "RealMeshPacket.h"
 #include "RealMeshConfig.h"
-#include <ArduinoJson.h>
+#include "RealMeshCompression.h"
+#include "RealMeshCrc16.h"
+#include <stddef.h>
 #include <vector>
 #include <algorithm>
 
@@ -8,51 +10,115 @@
 // Message Packet Implementation
 // ============================================================================
 
+static_assert(sizeof(MessageHeader) <= RM_HEADER_SIZE, "MessageHeader exceeds RM_HEADER_SIZE budget");
+static_assert(RM_MAX_HOP_COUNT <= 15, "v2 frames carry hop counts in 4 bits");
+
+RealMeshPacket::NodeResolver RealMeshPacket::nodeResolver = nullptr;
+RealMeshPacket::SubdomainResolver RealMeshPacket::subdomainResolver = nullptr;
+
 std::vector<uint8_t> RealMeshPacket::serialize(const MessagePacket& packet) {
     std::vector<uint8_t> buffer;
     buffer.reserve(RM_MAX_PACKET_SIZE);
+    serialize(packet, buffer);
+    return buffer;
+}
+
+void RealMeshPacket::serialize(const MessagePacket& packet, std::vector<uint8_t>& buffer) {
+    buffer.clear();
+    
+    // Relays rewrite hopCount and path history, so the checksum is stamped
+    // here rather than trusted from the packet. It covers the whole frame.
+    MessageHeader header = packet.header;
+    header.checksum = 0;
+    
+    // Aggregates are built byte for byte and have no header to patch
+    if (packet.header.messageType == MSG_AGGREGATE) {
+        buffer.insert(buffer.end(), packet.wire, packet.wire + packet.wireLength);
+        return;
+    }
     
-    // Serialize header (fixed size)
-    const uint8_t* headerPtr = reinterpret_cast<const uint8_t*>(&packet.header);
-    buffer.insert(buffer.end(), headerPtr, headerPtr + sizeof(MessageHeader));
+    // A received frame goes back out as received, with only the header
+    // fields a relay changes patched in
+    if (packet.wireLength > 0) {
+        buffer.insert(buffer.end(), packet.wire, packet.wire + packet.wireLength);
+        patchHeader(buffer.data(), buffer.size(), header);
+        return;
+    }
     
-    // Serialize source address
-    serializeNodeAddress(buffer, packet.source);
+    size_t checksumAt;
+    if (header.protocolVersion == RM_PROTOCOL_V1) {
+        // Serialize header (fixed size)
+        const uint8_t* headerPtr = reinterpret_cast<const uint8_t*>(&header);
+        buffer.insert(buffer.end(), headerPtr, headerPtr + sizeof(MessageHeader));
+        checksumAt = offsetof(MessageHeader, checksum);
+    } else {
+        header.timestamp = 0; // Not carried in v2
+        serializeHeaderV2(buffer, header);
+        checksumAt = HEADER_V2_CHECKSUM;
+    }
     
-    // Serialize destination address  
-    serializeNodeAddress(buffer, packet.destination);
+    // Checksum the header now and the rest as it is appended
+    uint16_t crc = RealMeshCrc16::update(RealMeshCrc16::INITIAL, buffer.data(), checksumAt);
+    crc = RealMeshCrc16::update(crc, buffer.data() + checksumAt + sizeof(uint16_t),
+                                buffer.size() - checksumAt - sizeof(uint16_t));
+    size_t mark = buffer.size();
+    
+    // Serialize source and destination addresses
+    if (header.protocolVersion == RM_PROTOCOL_V1) {
+        serializeNodeAddress(buffer, packet.source);
+        serializeNodeAddress(buffer, packet.destination);
+    } else {
+        serializeAddressV2(buffer, packet.source, sendsFullSource(header));
+        serializeAddressV2(buffer, packet.destination, sendsFullDestination(header));
+    }
     
     // Serialize payload
     buffer.insert(buffer.end(), packet.payload, packet.payload + packet.header.payloadLength);
     
-    return buffer;
+    crc = RealMeshCrc16::update(crc, buffer.data() + mark, buffer.size() - mark);
+    memcpy(buffer.data() + checksumAt, &crc, sizeof(uint16_t));
 }
 
-bool RealMeshPacket::deserialize(const std::vector<uint8_t>& data, MessagePacket& packet) {
-    if (data.size() < sizeof(MessageHeader)) {
-        return false;
+size_t RealMeshPacket::serializedSize(const MessagePacket& packet) {
+    if (packet.wireLength > 0) {
+        return packet.wireLength;
     }
     
-    const uint8_t* ptr = data.data();
-    size_t remaining = data.size();
-    
-    // Deserialize header
-    memcpy(&packet.header, ptr, sizeof(MessageHeader));
-    ptr += sizeof(MessageHeader);
-    remaining -= sizeof(MessageHeader);
-    
-    // Validate header checksum
-    if (!validateChecksum(packet.header)) {
-        return false;
+    return overheadSize(packet.header.protocolVersion, (MessageType)packet.header.messageType,
+                        packet.source, packet.destination) + packet.header.payloadLength;
+}
+
+size_t RealMeshPacket::overheadSize(uint8_t version, MessageType type,
+                                    const NodeAddress& source, const NodeAddress& destination) {
+    if (version == RM_PROTOCOL_V1) {
+        return sizeof(MessageHeader) + serializedAddressSize(source) + serializedAddressSize(destination);
     }
     
-    // Deserialize source address
-    if (!deserializeNodeAddress(ptr, remaining, packet.source)) {
+    MessageHeader header = {};
+    header.messageType = type;
+    return HEADER_V2_SIZE +
+           serializedAddressSizeV2(source, sendsFullSource(header)) +
+           serializedAddressSizeV2(destination, sendsFullDestination(header));
+}
+
+bool RealMeshPacket::deserialize(const std::vector<uint8_t>& data, MessagePacket& packet) {
+    return deserialize(data.data(), data.size(), packet);
+}
+
+bool RealMeshPacket::deserialize(const uint8_t* data, size_t length, MessagePacket& packet) {
+    // Check the header before resolving any addresses
+    size_t headerSize = 0;
+    if (!parseHeader(data, length, packet.header, headerSize)) {
         return false;
     }
     
-    // Deserialize destination address
-    if (!deserializeNodeAddress(ptr, remaining, packet.destination)) {
+    const uint8_t* ptr = data + headerSize;
+    size_t remaining = length - headerSize;
+    
+    // Deserialize source and destination addresses
+    uint8_t version = packet.header.protocolVersion;
+    if (!deserializeAddress(version, ptr, remaining, packet.source) ||
+        !deserializeAddress(version, ptr, remaining, packet.destination)) {
         return false;
     }
     
@@ -60,12 +126,40 @@ bool RealMeshPacket::deserialize(const std::vector<uint8_t>& data, MessagePacket
     if (remaining < packet.header.payloadLength) {
         return false;
     }
-    
     memcpy(packet.payload, ptr, packet.header.payloadLength);
     
+    // Keep the frame so a relay can send these bytes rather than re-encode
+    packet.wireLength = headerSize + (ptr - (data + headerSize)) + packet.header.payloadLength;
+    memcpy(packet.wire, data, packet.wireLength);
     return true;
 }
 
+void RealMeshPacket::setAddressResolvers(NodeResolver nodes, SubdomainResolver subdomains) {
+    nodeResolver = nodes;
+    subdomainResolver = subdomains;
+}
+
+uint16_t RealMeshPacket::subdomainHash(const String& subdomain) {
+    // Placeholders for unknown subdomains carry the hash they came with
+    if (subdomain.startsWith("#")) {
+        return (uint16_t)strtoul(subdomain.c_str() + 1, nullptr, 16);
+    }
+    
+    // FNV-1a folded to 16 bits
+    uint32_t hash = 2166136261u;
+    for (const char* p = subdomain.c_str(); *p; p++) {
+        hash = (hash ^ (uint8_t)*p) * 16777619u;
+    }
+    return (uint16_t)((hash >> 16) ^ (hash & 0xFFFF));
+}
+
+uint16_t RealMeshPacket::nextSequenceNumber() {
+    // One counter for every packet we originate, so neighbors can count
+    // the gaps to estimate how many of our frames they miss
+    static uint16_t sequenceCounter = 0;
+    return ++sequenceCounter;
+}
+
 uint32_t RealMeshPacket::generateMessageId(const NodeAddress& source, uint32_t timestamp, uint16_t sequence) {
     // Create unique message ID based on source UUID, timestamp, and sequence
     uint32_t id = 0;
@@ -82,23 +176,11 @@ uint32_t RealMeshPacket::generateMessageId(const NodeAddress& source, uint32_t t
     return id;
 }
 
-bool RealMeshPacket::validateChecksum(const MessageHeader& header) {
-    MessageHeader temp = header;
-    uint16_t originalChecksum = temp.checksum;
-    temp.checksum = 0;
-    
-    return calculateChecksum(temp) == originalChecksum;
-}
-
-uint16_t RealMeshPacket::calculateChecksum(const MessageHeader& header) {
-    const uint8_t* data = reinterpret_cast<const uint8_t*>(&header);
-    uint32_t sum = 0;
-    
-    for (size_t i = 0; i < sizeof(MessageHeader) - sizeof(uint16_t); i++) {
-        sum += data[i];
-    }
-    
-    return (uint16_t)(sum & 0xFFFF);
+uint16_t RealMeshPacket::frameChecksum(const uint8_t* frame, size_t length, size_t checksumAt) {
+    // Everything but the checksum field itself
+    uint16_t crc = RealMeshCrc16::update(RealMeshCrc16::INITIAL, frame, checksumAt);
+    return RealMeshCrc16::update(crc, frame + checksumAt + sizeof(uint16_t),
+                                 length - checksumAt - sizeof(uint16_t));
 }
 
 MessagePacket RealMeshPacket::createDataPacket(
@@ -109,7 +191,6 @@ MessagePacket RealMeshPacket::createDataPacket(
     bool encrypted
 ) {
     MessagePacket packet = {};
-    static uint16_t sequenceCounter = 0;
     
     // Fill header
     packet.header.protocolVersion = RM_PROTOCOL_VERSION;
@@ -120,30 +201,34 @@ MessagePacket RealMeshPacket::createDataPacket(
     packet.header.hopCount = 0;
     packet.header.maxHops = RM_MAX_HOP_COUNT;
     packet.header.timestamp = millis() / 1000; // Unix timestamp
-    packet.header.sequenceNumber = ++sequenceCounter;
+    packet.header.sequenceNumber = nextSequenceNumber();
     packet.header.messageId = generateMessageId(source, packet.header.timestamp, packet.header.sequenceNumber);
     
-    // Copy message to payload
+    // Copy message to payload, compressed when that makes it shorter
     size_t messageLen = std::min((size_t)message.length(), (size_t)RM_MAX_PAYLOAD_SIZE - 1);
-    message.getBytes(packet.payload, messageLen + 1);
-    packet.header.payloadLength = messageLen;
+    size_t compressedLen = RM_COMPRESSION_ENABLED ?
+        RealMeshCompression::compress(reinterpret_cast<const uint8_t*>(message.c_str()), messageLen,
+                                      packet.payload, RM_MAX_PAYLOAD_SIZE) : 0;
+    if (compressedLen > 0) {
+        packet.header.routingFlags |= ROUTE_COMPRESSED;
+        packet.header.payloadLength = compressedLen;
+    } else {
+        message.getBytes(packet.payload, messageLen + 1);
+        packet.header.payloadLength = messageLen;
+    }
     
     // Clear path history
-    memset(packet.header.pathHistory, 0, RM_PATH_HISTORY_SIZE);
+    memset(packet.header.pathHistory, 0, sizeof(packet.header.pathHistory));
     
     // Set addresses
     packet.source = source;
     packet.destination = destination;
     
-    // Calculate checksum
-    packet.header.checksum = calculateChecksum(packet.header);
-    
     return packet;
 }
 
-MessagePacket RealMeshPacket::createHeartbeatPacket(const NodeAddress& source, const HeartbeatData& heartbeat) {
+MessagePacket RealMeshPacket::createHeartbeatPacket(const NodeAddress& source, const HeartbeatData& heartbeat, uint8_t fields) {
     MessagePacket packet = {};
-    static uint16_t sequenceCounter = 0;
     
     // Fill header
     packet.header.protocolVersion = RM_PROTOCOL_VERSION;
@@ -153,34 +238,32 @@ MessagePacket RealMeshPacket::createHeartbeatPacket(const NodeAddress& source, c
     packet.header.hopCount = 0;
     packet.header.maxHops = 3; // Limited flood for heartbeats
     packet.header.timestamp = millis() / 1000;
-    packet.header.sequenceNumber = ++sequenceCounter;
+    packet.header.sequenceNumber = nextSequenceNumber();
     packet.header.messageId = generateMessageId(source, packet.header.timestamp, packet.header.sequenceNumber);
     
-    // Serialize heartbeat data to JSON
-    JsonDocument doc;
-    doc["status"] = heartbeat.status;
-    doc["uptime"] = heartbeat.uptime;
-    doc["contacts"] = heartbeat.directContacts.size();
-    doc["bridges"] = heartbeat.bridgedSubdomains.size();
-    doc["sent"] = heartbeat.stats.messagesSent;
-    doc["recv"] = heartbeat.stats.messagesReceived;
-    doc["rssi"] = heartbeat.stats.avgRSSI;
-    doc["load"] = heartbeat.stats.networkLoad;
+    // Payload: format, field mask, then the present fields in mask order.
+    // Counters are varints, RSSI and load one byte each (about 15 bytes).
+    HeartbeatSummary summary = summarizeHeartbeat(heartbeat);
+    std::vector<uint8_t> buffer;
+    buffer.push_back(RM_HEARTBEAT_FORMAT);
+    buffer.push_back(fields);
     
-    String jsonString;
-    serializeJson(doc, jsonString);
+    if (fields & HB_FIELD_STATUS) buffer.push_back(summary.status);
+    if (fields & HB_FIELD_UPTIME) serializeVarint(buffer, summary.uptimeSeconds);
+    if (fields & HB_FIELD_CONTACTS) serializeVarint(buffer, summary.directContacts);
+    if (fields & HB_FIELD_BRIDGES) serializeVarint(buffer, summary.bridgedSubdomains);
+    if (fields & HB_FIELD_SENT) serializeVarint(buffer, summary.messagesSent);
+    if (fields & HB_FIELD_RECEIVED) serializeVarint(buffer, summary.messagesReceived);
+    if (fields & HB_FIELD_RSSI) buffer.push_back((uint8_t)(-summary.avgRSSI));
+    if (fields & HB_FIELD_LOAD) buffer.push_back(summary.networkLoad);
     
-    size_t jsonLen = std::min((size_t)jsonString.length(), (size_t)RM_MAX_PAYLOAD_SIZE - 1);
-    jsonString.getBytes(packet.payload, jsonLen + 1);
-    packet.header.payloadLength = jsonLen;
+    memcpy(packet.payload, buffer.data(), buffer.size());
+    packet.header.payloadLength = buffer.size();
     
     // Set addresses (heartbeat destination is broadcast)
     packet.source = source;
     packet.destination = {}; // Empty destination = broadcast
     
-    // Calculate checksum
-    packet.header.checksum = calculateChecksum(packet.header);
-    
     return packet;
 }
 
@@ -190,7 +273,6 @@ MessagePacket RealMeshPacket::createAckPacket(
     uint32_t originalMessageId
 ) {
     MessagePacket packet = {};
-    static uint16_t sequenceCounter = 0;
     
     // Fill header
     packet.header.protocolVersion = RM_PROTOCOL_VERSION;
@@ -200,7 +282,7 @@ MessagePacket RealMeshPacket::createAckPacket(
     packet.header.hopCount = 0;
     packet.header.maxHops = RM_MAX_HOP_COUNT;
     packet.header.timestamp = millis() / 1000;
-    packet.header.sequenceNumber = ++sequenceCounter;
+    packet.header.sequenceNumber = nextSequenceNumber();
     packet.header.messageId = generateMessageId(source, packet.header.timestamp, packet.header.sequenceNumber);
     
     // Put original message ID in payload
@@ -211,9 +293,6 @@ MessagePacket RealMeshPacket::createAckPacket(
     packet.source = source;
     packet.destination = destination;
     
-    // Calculate checksum
-    packet.header.checksum = calculateChecksum(packet.header);
-    
     return packet;
 }
 
@@ -223,7 +302,6 @@ MessagePacket RealMeshPacket::createNameConflictPacket(
     const String& reason
 ) {
     MessagePacket packet = {};
-    static uint16_t sequenceCounter = 0;
     
     // Fill header
     packet.header.protocolVersion = RM_PROTOCOL_VERSION;
@@ -233,7 +311,7 @@ MessagePacket RealMeshPacket::createNameConflictPacket(
     packet.header.hopCount = 0;
     packet.header.maxHops = 1; // Direct only
     packet.header.timestamp = millis() / 1000;
-    packet.header.sequenceNumber = ++sequenceCounter;
+    packet.header.sequenceNumber = nextSequenceNumber();
     packet.header.messageId = generateMessageId(source, packet.header.timestamp, packet.header.sequenceNumber);
     
     // Put reason in payload
@@ -245,12 +323,307 @@ MessagePacket RealMeshPacket::createNameConflictPacket(
     packet.source = source;
     packet.destination = conflictingNode;
     
-    // Calculate checksum
-    packet.header.checksum = calculateChecksum(packet.header);
+    return packet;
+}
+
+MessagePacket RealMeshPacket::createRouteRequestPacket(
+    const NodeAddress& source,
+    const NodeAddress& destination,
+    uint8_t maxHops
+) {
+    MessagePacket packet = {};
+    
+    // Fill header
+    packet.header.protocolVersion = RM_PROTOCOL_VERSION;
+    packet.header.messageType = MSG_ROUTE_REQUEST;
+    packet.header.priority = PRIORITY_CONTROL;
+    packet.header.routingFlags = ROUTE_FLOOD; // Requests spread until someone knows the way
+    packet.header.hopCount = 0;
+    packet.header.maxHops = maxHops;
+    packet.header.timestamp = millis() / 1000;
+    packet.header.sequenceNumber = nextSequenceNumber();
+    packet.header.messageId = generateMessageId(source, packet.header.timestamp, packet.header.sequenceNumber);
+    
+    // No payload - the destination field names the node we are looking for
+    packet.header.payloadLength = 0;
+    
+    // Set addresses
+    packet.source = source;
+    packet.destination = destination;
     
     return packet;
 }
 
+MessagePacket RealMeshPacket::createRouteReplyPacket(
+    const NodeAddress& source,
+    const NodeAddress& requester,
+    const RouteReplyData& reply
+) {
+    MessagePacket packet = {};
+    
+    // Fill header
+    packet.header.protocolVersion = RM_PROTOCOL_VERSION;
+    packet.header.messageType = MSG_ROUTE_REPLY;
+    packet.header.priority = PRIORITY_CONTROL;
+    packet.header.routingFlags = ROUTE_DIRECT;
+    packet.header.hopCount = 0;
+    packet.header.maxHops = RM_MAX_HOP_COUNT;
+    packet.header.timestamp = millis() / 1000;
+    packet.header.sequenceNumber = nextSequenceNumber();
+    packet.header.messageId = generateMessageId(source, packet.header.timestamp, packet.header.sequenceNumber);
+    
+    // Payload: request ID, hop count, then the target address
+    std::vector<uint8_t> buffer;
+    const uint8_t* idPtr = reinterpret_cast<const uint8_t*>(&reply.requestId);
+    buffer.insert(buffer.end(), idPtr, idPtr + sizeof(uint32_t));
+    buffer.push_back(reply.hopCount);
+    serializeNodeAddress(buffer, reply.target);
+    
+    size_t payloadLen = std::min(buffer.size(), (size_t)RM_MAX_PAYLOAD_SIZE);
+    memcpy(packet.payload, buffer.data(), payloadLen);
+    packet.header.payloadLength = payloadLen;
+    
+    // Set addresses
+    packet.source = source;
+    packet.destination = requester;
+    
+    return packet;
+}
+
+bool RealMeshPacket::parseRouteReply(const MessagePacket& packet, RouteReplyData& reply) {
+    if (packet.header.messageType != MSG_ROUTE_REPLY ||
+        packet.header.payloadLength < sizeof(uint32_t) + 1) {
+        return false;
+    }
+    
+    const uint8_t* ptr = packet.payload;
+    size_t remaining = packet.header.payloadLength;
+    
+    memcpy(&reply.requestId, ptr, sizeof(uint32_t));
+    reply.hopCount = ptr[sizeof(uint32_t)];
+    ptr += sizeof(uint32_t) + 1;
+    remaining -= sizeof(uint32_t) + 1;
+    
+    return deserializeNodeAddress(ptr, remaining, reply.target) && reply.target.isValid();
+}
+
+MessagePacket RealMeshPacket::createFragmentPacket(
+    const NodeAddress& source,
+    const NodeAddress& destination,
+    const FragmentData& fragment,
+    MessagePriority priority,
+    bool compressed
+) {
+    MessagePacket packet = {};
+    
+    // Fill header
+    packet.header.protocolVersion = RM_PROTOCOL_VERSION;
+    packet.header.messageType = MSG_FRAGMENT;
+    packet.header.priority = priority;
+    packet.header.routingFlags = ROUTE_DIRECT;
+    if (compressed) packet.header.routingFlags |= ROUTE_COMPRESSED;
+    packet.header.hopCount = 0;
+    packet.header.maxHops = RM_MAX_HOP_COUNT;
+    packet.header.timestamp = millis() / 1000;
+    packet.header.sequenceNumber = nextSequenceNumber();
+    packet.header.messageId = generateMessageId(source, packet.header.timestamp, packet.header.sequenceNumber);
+    
+    // Payload: message ID, index, count, offset, then the data
+    uint32_t messageId = fragment.messageId != 0 ? fragment.messageId : packet.header.messageId;
+    size_t dataLen = std::min((size_t)fragment.length, (size_t)RM_MAX_PAYLOAD_SIZE - FRAGMENT_HEADER_SIZE);
+    memcpy(packet.payload, &messageId, sizeof(uint32_t));
+    packet.payload[4] = fragment.index;
+    packet.payload[5] = fragment.count;
+    memcpy(packet.payload + 6, &fragment.offset, sizeof(uint16_t));
+    memcpy(packet.payload + FRAGMENT_HEADER_SIZE, fragment.data, dataLen);
+    packet.header.payloadLength = FRAGMENT_HEADER_SIZE + dataLen;
+    
+    // Set addresses
+    packet.source = source;
+    packet.destination = destination;
+    
+    return packet;
+}
+
+bool RealMeshPacket::parseFragment(const MessagePacket& packet, FragmentData& fragment) {
+    if (packet.header.messageType != MSG_FRAGMENT || packet.header.payloadLength < FRAGMENT_HEADER_SIZE) {
+        return false;
+    }
+    
+    memcpy(&fragment.messageId, packet.payload, sizeof(uint32_t));
+    fragment.index = packet.payload[4];
+    fragment.count = packet.payload[5];
+    memcpy(&fragment.offset, packet.payload + 6, sizeof(uint16_t));
+    fragment.data = packet.payload + FRAGMENT_HEADER_SIZE;
+    fragment.length = packet.header.payloadLength - FRAGMENT_HEADER_SIZE;
+    
+    return fragment.count > 0 && fragment.count <= RM_FRAGMENT_MAX_COUNT &&
+           fragment.index < fragment.count &&
+           (size_t)fragment.offset + fragment.length <= RM_FRAGMENT_MAX_MESSAGE;
+}
+
+MessagePacket RealMeshPacket::createNackPacket(
+    const NodeAddress& source,
+    const NodeAddress& destination,
+    uint32_t messageId,
+    uint32_t missing
+) {
+    MessagePacket packet = {};
+    
+    // Fill header
+    packet.header.protocolVersion = RM_PROTOCOL_VERSION;
+    packet.header.messageType = MSG_NACK;
+    packet.header.priority = PRIORITY_CONTROL;
+    packet.header.routingFlags = ROUTE_DIRECT;
+    packet.header.hopCount = 0;
+    packet.header.maxHops = RM_MAX_HOP_COUNT;
+    packet.header.timestamp = millis() / 1000;
+    packet.header.sequenceNumber = nextSequenceNumber();
+    packet.header.messageId = generateMessageId(source, packet.header.timestamp, packet.header.sequenceNumber);
+    
+    // Payload: fragmented message ID, then one bit per missing fragment
+    memcpy(packet.payload, &messageId, sizeof(uint32_t));
+    memcpy(packet.payload + sizeof(uint32_t), &missing, sizeof(uint32_t));
+    packet.header.payloadLength = 2 * sizeof(uint32_t);
+    
+    // Set addresses
+    packet.source = source;
+    packet.destination = destination;
+    
+    return packet;
+}
+
+bool RealMeshPacket::parseNack(const MessagePacket& packet, uint32_t& messageId, uint32_t& missing) {
+    if (packet.header.messageType != MSG_NACK || packet.header.payloadLength < 2 * sizeof(uint32_t)) {
+        return false;
+    }
+    
+    memcpy(&messageId, packet.payload, sizeof(uint32_t));
+    memcpy(&missing, packet.payload + sizeof(uint32_t), sizeof(uint32_t));
+    return true;
+}
+
+void RealMeshPacket::initAggregate(MessagePacket& aggregate, const MessagePacket& first) {
+    aggregate.header = {};
+    
+    // The first member decides where the container goes and on which
+    // profile; the radio reads nextHop, messageId and priority from here
+    aggregate.header.protocolVersion = RM_PROTOCOL_V2;
+    aggregate.header.messageType = MSG_AGGREGATE;
+    aggregate.header.priority = first.header.priority;
+    aggregate.header.routingFlags = first.header.routingFlags;
+    aggregate.header.nextHop = first.header.nextHop;
+    aggregate.header.messageId = first.header.messageId;
+    aggregate.source = first.source;
+    aggregate.destination = first.destination;
+    
+    aggregate.wire[0] = RM_PROTOCOL_V2;
+    aggregate.wire[1] = MSG_AGGREGATE;
+    aggregate.wireLength = AGGREGATE_HEADER_SIZE;
+    
+    appendToAggregate(aggregate, first);
+}
+
+bool RealMeshPacket::appendToAggregate(MessagePacket& aggregate, const MessagePacket& frame) {
+    std::vector<uint8_t> data = serialize(frame);
+    if (data.size() > UINT8_MAX || aggregate.wireLength + 1 + data.size() > RM_MAX_PACKET_SIZE) {
+        return false;
+    }
+    
+    aggregate.wire[aggregate.wireLength++] = data.size();
+    memcpy(aggregate.wire + aggregate.wireLength, data.data(), data.size());
+    aggregate.wireLength += data.size();
+    
+    // The container goes out as urgently as its most urgent member
+    aggregate.header.priority = std::min(aggregate.header.priority, frame.header.priority);
+    return true;
+}
+
+bool RealMeshPacket::isAggregate(const uint8_t* data, size_t length) {
+    return length > AGGREGATE_HEADER_SIZE && data[0] == RM_PROTOCOL_V2 && data[1] == MSG_AGGREGATE;
+}
+
+bool RealMeshPacket::nextAggregateMember(const uint8_t* data, size_t length, size_t& offset,
+                                         const uint8_t*& member, size_t& memberLength) {
+    if (offset < AGGREGATE_HEADER_SIZE) {
+        offset = AGGREGATE_HEADER_SIZE;
+    }
+    
+    // A length running past the end means the rest is unusable
+    if (offset >= length || data[offset] == 0 || offset + 1 + data[offset] > length) {
+        return false;
+    }
+    
+    memberLength = data[offset];
+    member = data + offset + 1;
+    offset += 1 + memberLength;
+    return true;
+}
+
+HeartbeatSummary RealMeshPacket::summarizeHeartbeat(const HeartbeatData& heartbeat) {
+    HeartbeatSummary summary = {};
+    summary.fields = HB_FIELD_ALL;
+    summary.status = heartbeat.status;
+    summary.uptimeSeconds = heartbeat.uptime / 1000;
+    summary.directContacts = std::min(heartbeat.directContacts.size(), (size_t)UINT16_MAX);
+    summary.bridgedSubdomains = std::min(heartbeat.bridgedSubdomains.size(), (size_t)UINT16_MAX);
+    summary.messagesSent = heartbeat.stats.messagesSent;
+    summary.messagesReceived = heartbeat.stats.messagesReceived;
+    summary.avgRSSI = (int16_t)constrain(lroundf(heartbeat.stats.avgRSSI), -255L, 0L);
+    summary.networkLoad = std::min(heartbeat.stats.networkLoad, (uint8_t)100);
+    return summary;
+}
+
+bool RealMeshPacket::parseHeartbeat(const MessagePacket& packet, HeartbeatSummary& summary) {
+    if (packet.header.messageType != MSG_HEARTBEAT || packet.header.payloadLength < 2 ||
+        packet.payload[0] != RM_HEARTBEAT_FORMAT) {
+        return false;
+    }
+    
+    const uint8_t* ptr = packet.payload + 2;
+    size_t remaining = packet.header.payloadLength - 2;
+    uint8_t fields = packet.payload[1];
+    uint32_t value = 0;
+    
+    summary = {};
+    summary.fields = fields;
+    
+    if (fields & HB_FIELD_STATUS) {
+        if (remaining < 1) return false;
+        summary.status = (NodeStatus)*ptr++;
+        remaining--;
+    }
+    if (fields & HB_FIELD_UPTIME) {
+        if (!deserializeVarint(ptr, remaining, summary.uptimeSeconds)) return false;
+    }
+    if (fields & HB_FIELD_CONTACTS) {
+        if (!deserializeVarint(ptr, remaining, value)) return false;
+        summary.directContacts = std::min(value, (uint32_t)UINT16_MAX);
+    }
+    if (fields & HB_FIELD_BRIDGES) {
+        if (!deserializeVarint(ptr, remaining, value)) return false;
+        summary.bridgedSubdomains = std::min(value, (uint32_t)UINT16_MAX);
+    }
+    if (fields & HB_FIELD_SENT) {
+        if (!deserializeVarint(ptr, remaining, summary.messagesSent)) return false;
+    }
+    if (fields & HB_FIELD_RECEIVED) {
+        if (!deserializeVarint(ptr, remaining, summary.messagesReceived)) return false;
+    }
+    if (fields & HB_FIELD_RSSI) {
+        if (remaining < 1) return false;
+        summary.avgRSSI = -(int16_t)*ptr++;
+        remaining--;
+    }
+    if (fields & HB_FIELD_LOAD) {
+        if (remaining < 1) return false;
+        summary.networkLoad = std::min(*ptr++, (uint8_t)100);
+        remaining--;
+    }
+    
+    return true;
+}
+
 String RealMeshPacket::packetToString(const MessagePacket& packet) {
     String result = "Packet[";
     result += "ID:" + String(packet.header.messageId, HEX);
@@ -269,6 +642,7 @@ void RealMeshPacket::printPacketDebug(const MessagePacket& packet) {
     Serial.printf("Type: %d, Priority: %d\n", packet.header.messageType, packet.header.priority);
     Serial.printf("Routing Flags: 0x%02X\n", packet.header.routingFlags);
     Serial.printf("Hop Count: %d/%d\n", packet.header.hopCount, packet.header.maxHops);
+    Serial.printf("Next Hop: 0x%04X\n", packet.header.nextHop);
     Serial.printf("Source: %s\n", packet.source.getFullAddress().c_str());
     Serial.printf("Destination: %s\n", packet.destination.getFullAddress().c_str());
     Serial.printf("Payload Length: %d\n", packet.header.payloadLength);
@@ -284,6 +658,13 @@ void RealMeshPacket::serializeNodeAddress(std::vector<uint8_t>& buffer, const No
     serializeUUID(buffer, address.uuid);
 }
 
+size_t RealMeshPacket::serializedAddressSize(const NodeAddress& address) {
+    // Length-prefixed strings (capped at 255) plus the raw UUID
+    return 1 + std::min((size_t)address.nodeId.length(), (size_t)255) +
+           1 + std::min((size_t)address.subdomain.length(), (size_t)255) +
+           RM_UUID_LENGTH;
+}
+
 bool RealMeshPacket::deserializeNodeAddress(const uint8_t*& data, size_t& remaining, NodeAddress& address) {
     return deserializeString(data, remaining, address.nodeId) &&
            deserializeString(data, remaining, address.subdomain) &&
@@ -327,4 +708,292 @@ bool RealMeshPacket::deserializeUUID(const uint8_t*& data, size_t& remaining, No
     data += RM_UUID_LENGTH;
     remaining -= RM_UUID_LENGTH;
     return true;
-}
\ No newline at end of file
+}
+
+void RealMeshPacket::serializeVarint(std::vector<uint8_t>& buffer, uint32_t value) {
+    // LEB128: 7 bits per byte, high bit set on all but the last
+    while (value >= 0x80) {
+        buffer.push_back((uint8_t)(value | 0x80));
+        value >>= 7;
+    }
+    buffer.push_back((uint8_t)value);
+}
+
+bool RealMeshPacket::deserializeVarint(const uint8_t*& data, size_t& remaining, uint32_t& value) {
+    value = 0;
+    for (uint8_t shift = 0; shift < 35; shift += 7) {
+        if (remaining < 1) return false;
+        
+        uint8_t byte = *data++;
+        remaining--;
+        value |= (uint32_t)(byte & 0x7F) << shift;
+        if (!(byte & 0x80)) return true;
+    }
+    return false; // Longer than any uint32_t encoding
+}
+
+bool RealMeshPacket::parseHeader(const uint8_t* data, size_t length, MessageHeader& header, size_t& headerSize) {
+    // v1 keeps its version byte inside the header struct, v2 leads with it.
+    // Either position can hold the other's value by chance; the checksum
+    // settles it. It covers the whole frame, so a corrupted address or
+    // payload is rejected here, before anything is decoded.
+    if (length >= sizeof(MessageHeader) && data[offsetof(MessageHeader, protocolVersion)] == RM_PROTOCOL_V1) {
+        memcpy(&header, data, sizeof(MessageHeader));
+        if (frameChecksum(data, length, offsetof(MessageHeader, checksum)) == header.checksum) {
+            headerSize = sizeof(MessageHeader);
+            return true;
+        }
+    }
+    
+    if (length < HEADER_V2_SIZE || data[0] != RM_PROTOCOL_V2) {
+        return false;
+    }
+    
+    uint16_t checksum;
+    memcpy(&checksum, data + HEADER_V2_CHECKSUM, sizeof(uint16_t));
+    if (frameChecksum(data, length, HEADER_V2_CHECKSUM) != checksum) {
+        return false;
+    }
+    
+    header.protocolVersion = data[0];
+    header.messageType = data[1];
+    header.priority = data[2];
+    header.routingFlags = data[3];
+    header.hopCount = data[4] >> 4;
+    header.maxHops = data[4] & 0x0F;
+    header.payloadLength = data[5];
+    memcpy(&header.messageId, data + 6, sizeof(uint32_t));
+    memcpy(&header.sequenceNumber, data + 10, sizeof(uint16_t));
+    memcpy(header.pathHistory, data + 12, sizeof(header.pathHistory));
+    memcpy(&header.nextHop, data + 18, sizeof(uint16_t));
+    header.checksum = checksum;
+    header.timestamp = 0;
+    headerSize = HEADER_V2_SIZE;
+    return true;
+}
+
+bool RealMeshPacket::deserializeAddress(uint8_t version, const uint8_t*& data, size_t& remaining, NodeAddress& address) {
+    return version == RM_PROTOCOL_V1 ? deserializeNodeAddress(data, remaining, address)
+                                     : deserializeAddressV2(data, remaining, address);
+}
+
+bool RealMeshPacket::skipAddress(uint8_t version, const uint8_t*& data, size_t& remaining, uint16_t* shortId) {
+    // Step over an encoded address without building any Strings
+    size_t size = 0;
+    const uint8_t* uuid = nullptr;
+    
+    if (version != RM_PROTOCOL_V1) {
+        if (remaining < 1) return false;
+        
+        uint8_t form = *data++;
+        remaining--;
+        switch (form) {
+            case ADDRESS_BROADCAST:
+                size = 0;
+                break;
+            case ADDRESS_SUBDOMAIN:
+                size = sizeof(uint16_t);
+                break;
+            case ADDRESS_HASHED:
+                size = sizeof(uint32_t) + 2 * sizeof(uint16_t);
+                if (remaining >= size && shortId) {
+                    memcpy(shortId, data + 6, sizeof(uint16_t));
+                }
+                break;
+            case ADDRESS_FULL:
+                version = RM_PROTOCOL_V1; // v1 encoding follows
+                break;
+            default:
+                return false;
+        }
+    }
+    
+    if (version == RM_PROTOCOL_V1) {
+        // Two length-prefixed strings, then the UUID
+        if (remaining < 1 || remaining < 1u + data[0] + 1u) return false;
+        size_t subdomainAt = 1 + data[0];
+        size = subdomainAt + 1 + data[subdomainAt] + RM_UUID_LENGTH;
+        uuid = data + size - RM_UUID_LENGTH;
+    }
+    
+    if (remaining < size) return false;
+    
+    if (uuid && shortId) {
+        NodeUUID id;
+        memcpy(id.bytes, uuid, RM_UUID_LENGTH);
+        *shortId = id.isSet() ? id.getShortId() : 0;
+    }
+    
+    data += size;
+    remaining -= size;
+    return true;
+}
+
+void RealMeshPacket::patchHeader(uint8_t* frame, size_t length, MessageHeader header) {
+    size_t checksumAt;
+    if (header.protocolVersion == RM_PROTOCOL_V1) {
+        memcpy(frame, &header, sizeof(MessageHeader));
+        checksumAt = offsetof(MessageHeader, checksum);
+    } else {
+        header.timestamp = 0;
+        encodeHeaderV2(frame, header);
+        checksumAt = HEADER_V2_CHECKSUM;
+    }
+    
+    uint16_t crc = frameChecksum(frame, length, checksumAt);
+    memcpy(frame + checksumAt, &crc, sizeof(uint16_t));
+}
+
+void RealMeshPacket::serializeHeaderV2(std::vector<uint8_t>& buffer, const MessageHeader& header) {
+    uint8_t bytes[HEADER_V2_SIZE];
+    encodeHeaderV2(bytes, header);
+    buffer.insert(buffer.end(), bytes, bytes + HEADER_V2_SIZE);
+}
+
+void RealMeshPacket::encodeHeaderV2(uint8_t* bytes, const MessageHeader& header) {
+    bytes[0] = header.protocolVersion;
+    bytes[1] = header.messageType;
+    bytes[2] = header.priority;
+    bytes[3] = header.routingFlags;
+    bytes[4] = (std::min(header.hopCount, (uint8_t)15) << 4) | std::min(header.maxHops, (uint8_t)15);
+    bytes[5] = header.payloadLength;
+    memcpy(bytes + 6, &header.messageId, sizeof(uint32_t));
+    memcpy(bytes + 10, &header.sequenceNumber, sizeof(uint16_t));
+    memcpy(bytes + 12, header.pathHistory, sizeof(header.pathHistory));
+    memcpy(bytes + 18, &header.nextHop, sizeof(uint16_t));
+    memcpy(bytes + HEADER_V2_CHECKSUM, &header.checksum, sizeof(uint16_t));
+}
+
+void RealMeshPacket::serializeAddressV2(std::vector<uint8_t>& buffer, const NodeAddress& address, bool full) {
+    if (address.nodeId.isEmpty()) {
+        if (address.subdomain.isEmpty()) {
+            buffer.push_back(ADDRESS_BROADCAST);
+            return;
+        }
+        
+        uint16_t subdomain = subdomainHash(address.subdomain);
+        buffer.push_back(ADDRESS_SUBDOMAIN);
+        buffer.insert(buffer.end(), (const uint8_t*)&subdomain, (const uint8_t*)&subdomain + sizeof(uint16_t));
+        return;
+    }
+    
+    if (full && !isPlaceholder(address)) {
+        buffer.push_back(ADDRESS_FULL);
+        serializeNodeAddress(buffer, address);
+        return;
+    }
+    
+    uint32_t hash = wireAddressHash(address);
+    uint16_t subdomain = subdomainHash(address.subdomain);
+    uint16_t shortId = address.uuid.isSet() ? address.uuid.getShortId() : 0;
+    buffer.push_back(ADDRESS_HASHED);
+    buffer.insert(buffer.end(), (const uint8_t*)&hash, (const uint8_t*)&hash + sizeof(uint32_t));
+    buffer.insert(buffer.end(), (const uint8_t*)&subdomain, (const uint8_t*)&subdomain + sizeof(uint16_t));
+    buffer.insert(buffer.end(), (const uint8_t*)&shortId, (const uint8_t*)&shortId + sizeof(uint16_t));
+}
+
+size_t RealMeshPacket::serializedAddressSizeV2(const NodeAddress& address, bool full) {
+    if (address.nodeId.isEmpty()) {
+        return address.subdomain.isEmpty() ? 1 : 1 + sizeof(uint16_t);
+    }
+    if (full && !isPlaceholder(address)) {
+        return 1 + serializedAddressSize(address);
+    }
+    return 1 + sizeof(uint32_t) + 2 * sizeof(uint16_t);
+}
+
+bool RealMeshPacket::deserializeAddressV2(const uint8_t*& data, size_t& remaining, NodeAddress& address) {
+    if (remaining < 1) return false;
+    
+    uint8_t form = *data++;
+    remaining--;
+    address = NodeAddress();
+    
+    switch (form) {
+        case ADDRESS_BROADCAST:
+            return true;
+            
+        case ADDRESS_SUBDOMAIN: {
+            if (remaining < sizeof(uint16_t)) return false;
+            
+            uint16_t subdomain;
+            memcpy(&subdomain, data, sizeof(uint16_t));
+            data += sizeof(uint16_t);
+            remaining -= sizeof(uint16_t);
+            
+            address.subdomain = resolveSubdomain(subdomain);
+            return true;
+        }
+            
+        case ADDRESS_HASHED: {
+            if (remaining < sizeof(uint32_t) + 2 * sizeof(uint16_t)) return false;
+            
+            uint32_t hash;
+            uint16_t subdomain;
+            uint16_t shortId;
+            memcpy(&hash, data, sizeof(uint32_t));
+            memcpy(&subdomain, data + 4, sizeof(uint16_t));
+            memcpy(&shortId, data + 6, sizeof(uint16_t));
+            data += sizeof(uint32_t) + 2 * sizeof(uint16_t);
+            remaining -= sizeof(uint32_t) + 2 * sizeof(uint16_t);
+            
+            if (!nodeResolver || !nodeResolver(hash, shortId, address)) {
+                address.nodeId = "#" + String(hash, HEX);
+                address.subdomain = resolveSubdomain(subdomain);
+            }
+            
+            // Without a known UUID, keep at least the short ID it was sent with
+            if (!address.uuid.isSet() && shortId != 0) {
+                address.uuid.bytes[0] = shortId >> 8;
+                address.uuid.bytes[1] = shortId & 0xFF;
+                memcpy(address.uuid.bytes + 2, &hash, sizeof(uint32_t));
+            }
+            return true;
+        }
+            
+        case ADDRESS_FULL:
+            return deserializeNodeAddress(data, remaining, address);
+            
+        default:
+            return false;
+    }
+}
+
+bool RealMeshPacket::sendsFullSource(const MessageHeader& header) {
+    // Frames other nodes learn our name from
+    switch (header.messageType) {
+        case MSG_HEARTBEAT:
+        case MSG_ROUTE_REQUEST:
+        case MSG_ROUTE_REPLY:
+        case MSG_NAME_CONFLICT:
+            return true;
+        default:
+            return false;
+    }
+}
+
+bool RealMeshPacket::sendsFullDestination(const MessageHeader& header) {
+    // A name conflict is about the name itself; the node holding it may not
+    // be the one whose short ID the sender knows
+    return header.messageType == MSG_NAME_CONFLICT;
+}
+
+uint32_t RealMeshPacket::wireAddressHash(const NodeAddress& address) {
+    // Placeholders for unknown nodes carry the hash they came with
+    if (isPlaceholder(address)) {
+        return strtoul(address.nodeId.c_str() + 1, nullptr, 16);
+    }
+    return address.getAddressHash();
+}
+
+bool RealMeshPacket::isPlaceholder(const NodeAddress& address) {
+    return address.nodeId.startsWith("#");
+}
+
+String RealMeshPacket::resolveSubdomain(uint16_t hash) {
+    String subdomain;
+    if (subdomainResolver && subdomainResolver(hash, subdomain)) {
+        return subdomain;
+    }
+    return "#" + String(hash, HEX);
+}
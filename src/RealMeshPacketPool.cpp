@@ -0,0 +1,126 @@
+#include "RealMeshPacketPool.h"
+#include "RealMeshConfig.h"
+
+// ============================================================================
+// Fixed Packet Pool Implementation
+// ============================================================================
+
+static_assert(RM_PACKET_POOL_SIZE <= UINT8_MAX, "Slot indices are kept in a uint8_t");
+
+MessagePacket RealMeshPacketPool::slots[RM_PACKET_POOL_SIZE];
+uint8_t RealMeshPacketPool::refCounts[RM_PACKET_POOL_SIZE] = {};
+uint8_t RealMeshPacketPool::nextSlot = 0;
+uint32_t RealMeshPacketPool::exhausted = 0;
+
+PacketHandle RealMeshPacketPool::acquire() {
+    // Round robin, so a slot just released isn't handed out again at once
+    for (uint8_t i = 0; i < RM_PACKET_POOL_SIZE; i++) {
+        uint8_t slot = (nextSlot + i) % RM_PACKET_POOL_SIZE;
+        if (refCounts[slot] != 0) {
+            continue;
+        }
+        
+        refCounts[slot] = 1;
+        nextSlot = (slot + 1) % RM_PACKET_POOL_SIZE;
+        
+        MessagePacket& packet = slots[slot];
+        memset(&packet.header, 0, sizeof(MessageHeader));
+        packet.wireLength = 0;
+        return PacketHandle(&packet);
+    }
+    
+    exhausted++;
+    return PacketHandle();
+}
+
+PacketHandle RealMeshPacketPool::acquire(const MessagePacket& packet) {
+    PacketHandle handle = acquire();
+    if (handle) {
+        // The payload and raw frame are copied only as far as they're used
+        handle->header = packet.header;
+        handle->source = packet.source;
+        handle->destination = packet.destination;
+        memcpy(handle->payload, packet.payload, min((size_t)packet.header.payloadLength, sizeof(packet.payload)));
+        handle->wireLength = packet.wireLength;
+        memcpy(handle->wire, packet.wire, packet.wireLength);
+    }
+    return handle;
+}
+
+size_t RealMeshPacketPool::available() {
+    size_t free = 0;
+    for (uint8_t i = 0; i < RM_PACKET_POOL_SIZE; i++) {
+        if (refCounts[i] == 0) {
+            free++;
+        }
+    }
+    return free;
+}
+
+// Private methods
+
+void RealMeshPacketPool::retain(MessagePacket* packet) {
+    refCounts[packet - slots]++;
+}
+
+void RealMeshPacketPool::release(MessagePacket* packet) {
+    uint8_t& count = refCounts[packet - slots];
+    if (count > 0) {
+        count--;
+    }
+}
+
+uint8_t RealMeshPacketPool::refCount(const MessagePacket* packet) {
+    return refCounts[packet - slots];
+}
+
+// PacketHandle
+
+PacketHandle::PacketHandle(const PacketHandle& other) : packet(other.packet) {
+    if (packet) {
+        RealMeshPacketPool::retain(packet);
+    }
+}
+
+PacketHandle& PacketHandle::operator=(const PacketHandle& other) {
+    if (other.packet) {
+        RealMeshPacketPool::retain(other.packet);
+    }
+    reset();
+    packet = other.packet;
+    return *this;
+}
+
+PacketHandle& PacketHandle::operator=(PacketHandle&& other) {
+    if (this != &other) {
+        reset();
+        packet = other.packet;
+        other.packet = nullptr;
+    }
+    return *this;
+}
+
+void PacketHandle::reset() {
+    if (packet) {
+        RealMeshPacketPool::release(packet);
+        packet = nullptr;
+    }
+}
+
+bool PacketHandle::isShared() const {
+    return packet && RealMeshPacketPool::refCount(packet) > 1;
+}
+
+bool PacketHandle::detach() {
+    if (!isShared()) {
+        return packet != nullptr;
+    }
+    
+    PacketHandle copy = RealMeshPacketPool::acquire(*packet);
+    if (!copy) {
+        return false;
+    }
+    
+    *this = std::move(copy);
+    return true;
+}
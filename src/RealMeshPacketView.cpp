@@ -0,0 +1,103 @@
+#include "RealMeshPacketView.h"
+#include "RealMeshPacket.h"
+#include "RealMeshConfig.h"
+
+// ============================================================================
+// Lazy Frame Decoder Implementation
+// ============================================================================
+
+RealMeshPacketView::RealMeshPacketView(const uint8_t* data, size_t length) :
+    bytes(data),
+    size(length),
+    headerSize(0),
+    valid(false),
+    addressesLocated(false),
+    destinationOffset(0),
+    sourceId(0) {
+    
+    memset(&parsedHeader, 0, sizeof(parsedHeader));
+    valid = data != nullptr && RealMeshPacket::parseHeader(data, length, parsedHeader, headerSize);
+}
+
+uint16_t RealMeshPacketView::sourceShortId() const {
+    return locateAddresses() ? sourceId : 0;
+}
+
+uint16_t RealMeshPacketView::transmitterShortId() const {
+    return parsedHeader.pathHistory[0] != 0 ? parsedHeader.pathHistory[0] : sourceShortId();
+}
+
+bool RealMeshPacketView::isAddressedTo(const NodeAddress& address) const {
+    if (!locateAddresses() || !address.isValid()) {
+        return false;
+    }
+    
+    const uint8_t* ptr = bytes + destinationOffset;
+    size_t remaining = size - destinationOffset;
+    
+    if (parsedHeader.protocolVersion != RM_PROTOCOL_V1) {
+        uint8_t form = *ptr++;
+        remaining--;
+        
+        if (form == RealMeshPacket::ADDRESS_HASHED) {
+            uint32_t hash;
+            uint16_t shortId;
+            memcpy(&hash, ptr, sizeof(uint32_t));
+            memcpy(&shortId, ptr + 6, sizeof(uint16_t));
+            return hash == RealMeshPacket::wireAddressHash(address) &&
+                   (shortId == 0 || !address.uuid.isSet() || shortId == address.uuid.getShortId());
+        }
+        if (form != RealMeshPacket::ADDRESS_FULL) {
+            return false; // Broadcast or subdomain
+        }
+    }
+    
+    // v1 encoding: compare the strings in place
+    return matchString(ptr, remaining, address.nodeId) &&
+           matchString(ptr, remaining, address.subdomain);
+}
+
+bool RealMeshPacketView::decode(MessagePacket& packet) const {
+    return valid && RealMeshPacket::deserialize(bytes, size, packet);
+}
+
+// Private methods
+
+bool RealMeshPacketView::locateAddresses() const {
+    if (addressesLocated) {
+        return destinationOffset != 0;
+    }
+    addressesLocated = true;
+    
+    if (!valid) {
+        return false;
+    }
+    
+    const uint8_t* ptr = bytes + headerSize;
+    size_t remaining = size - headerSize;
+    uint8_t version = parsedHeader.protocolVersion;
+    
+    if (!RealMeshPacket::skipAddress(version, ptr, remaining, &sourceId)) {
+        return false;
+    }
+    
+    // Make sure the destination is all there before anyone reads it
+    const uint8_t* destination = ptr;
+    if (!RealMeshPacket::skipAddress(version, ptr, remaining, nullptr)) {
+        return false;
+    }
+    
+    destinationOffset = destination - bytes;
+    return true;
+}
+
+bool RealMeshPacketView::matchString(const uint8_t*& data, size_t& remaining, const String& str) {
+    if (remaining < 1 || data[0] != str.length() || remaining < 1u + data[0]) {
+        return false;
+    }
+    
+    bool match = memcmp(data + 1, str.c_str(), data[0]) == 0;
+    remaining -= 1 + data[0];
+    data += 1 + data[0];
+    return match;
+}
@@ -6,9 +6,34 @@
 // LoRa Radio Implementation
 // ============================================================================
 
+// A maximum-size frame must fit inside the transmit watchdog
+static_assert(RealMeshAirtime::timeOnAirMs(RM_MAX_PACKET_SIZE, RM_SPREADING_FACTOR, RM_BANDWIDTH_KHZ, RM_CODING_RATE,
+                                          RM_ADR_ENABLED ? RM_PROFILE_SLOW_PREAMBLE : RM_PREAMBLE_LENGTH) < RM_TX_TIMEOUT_MS,
+              "RM_TX_TIMEOUT_MS is shorter than a full frame at the configured modulation");
+
 // Static instance for interrupt callbacks
 RealMeshRadio* RealMeshRadio::instance = nullptr;
 
+// How long a CAD on this profile may go without CadDone
+static uint32_t cadTimeoutMs(RadioProfile profile) {
+    const RadioProfileParams& params = RealMeshLinkProfiles::params(profile);
+    return RealMeshAirtime::symbolTimeUs(params.spreadingFactor, params.bandwidthKhz) * RM_CAD_TIMEOUT_SYMBOLS / 1000 + 1;
+}
+
+// Holds the radio's SPI bus for the loop or the scan task
+class RadioLock {
+public:
+    explicit RadioLock(SemaphoreHandle_t lock) : lock(lock) {
+        if (lock) xSemaphoreTakeRecursive(lock, portMAX_DELAY);
+    }
+    ~RadioLock() {
+        if (lock) xSemaphoreGiveRecursive(lock);
+    }
+    
+private:
+    SemaphoreHandle_t lock;
+};
+
 RealMeshRadio::RealMeshRadio() : 
     radio(new Module(RM_LORA_CS, RM_LORA_DIO1, RM_LORA_RST, RM_LORA_BUSY)),
     initialized(false),
@@ -16,14 +41,44 @@ RealMeshRadio::RealMeshRadio() :
     receiving(false),
     lastTransmission(0),
     lastReception(0),
+    txStartTime(0),
+    txBytes(0),
+    txSourceId(0),
+    txMessageId(0),
+    radioState(RADIO_RX),
+    cadAttempts(0),
+    backoffUntil(0),
+    cadDeadline(0),
+    currentProfile(PROFILE_COUNT),
+    txProfile(PROFILE_SLOW),
+    txPreamble(RM_PREAMBLE_LENGTH),
+    txAirtimeMs(0),
+    currentPreamble(RM_PREAMBLE_LENGTH),
+    scanIndex(0),
+    rxLockUntil(0),
+    scanTask(nullptr),
+    radioLock(nullptr),
+    dutyCycleBlocked(false),
+    txDoneFlag(false),
+    rxDoneFlag(false),
+    cadDoneFlag(false),
+    rxTimestamp(0),
     messagesSent(0),
     messagesReceived(0),
     transmitErrors(0),
     receiveErrors(0),
     bytesTransmitted(0),
     bytesReceived(0),
+    channelDeferrals(0),
+    channelBusyDrops(0),
+    dutyCycleDeferrals(0),
     channelBusyTime(0),
     channelSampleTime(0),
+    channelSampleWindow(RM_CHANNEL_SAMPLE_MS),
+    channelUtilization(0.0),
+    txAirtime(0),
+    rxAirtime(0),
+    backoffTime(0),
     avgRSSI(-100.0),
     avgSNR(-10.0),
     messageCallback(nullptr),
@@ -31,6 +86,7 @@ RealMeshRadio::RealMeshRadio() :
     
     // Set static instance for interrupt callbacks
     instance = this;
+    txFrame.reserve(RM_MAX_PACKET_SIZE);
 }
 
 
@@ -148,6 +204,9 @@ bool RealMeshRadio::begin() {
         // Continue anyway - not critical
     }
     
+    // TxDone, RxDone and CadDone all arrive on DIO1
+    radio.setDio1Action(onDio1Interrupt);
+    
     // Start receiving (Meshtastic calls startReceive() at the end)
     res = radio.startReceive();
     if (res == RADIOLIB_ERR_NONE) {
@@ -159,6 +218,20 @@ bool RealMeshRadio::begin() {
     }
     
     initialized = true;
+    channelSampleTime = millis();
+    
+    // Scan steps follow each other straight from the CAD-done interrupt;
+    // waiting for the loop would stretch the cycle past the preambles
+    if (RM_ADR_ENABLED && !scanTask) {
+        radioLock = xSemaphoreCreateRecursiveMutex();
+        if (!radioLock || xTaskCreate(runScanTask, "rm_scan", 4096, this, 2, &scanTask) != pdPASS) {
+            Serial.println("[RADIO] Failed to start scan task, scanning from the loop");
+            scanTask = nullptr;
+        }
+    }
+    
+    // From here on, listen on every link profile
+    startListening();
     
     Serial.println("[RADIO] === SX1262 INITIALIZATION COMPLETE ===");
     Serial.println("[RADIO] Using exact Meshtastic initialization sequence");
@@ -175,101 +248,470 @@ void RealMeshRadio::end() {
     
     Serial.println("[RADIO] Shutting down radio...");
     
+    RadioLock lock(radioLock);
+    radio.clearDio1Action();
     radio.standby();
     initialized = false;
     transmitting = false;
     receiving = false;
+    radioState = RADIO_RX;
     
     Serial.println("[RADIO] Radio shutdown complete");
 }
 
 bool RealMeshRadio::sendPacket(const MessagePacket& packet) {
-    if (!initialized || transmitting) {
+    if (!initialized) {
         Serial.println("[RADIO] Cannot send - radio not ready");
         return false;
     }
     
-    // Serialize packet to bytes
-    std::vector<uint8_t> data = RealMeshPacket::serialize(packet);
+    RadioLock lock(radioLock);
+    
+    // The caller keeps the packet queued and tries again next loop
+    if (isBusy()) {
+        return false;
+    }
+    
+    // Serialize straight into the frame buffer; it is idle, and its
+    // capacity was reserved once at construction
+    RealMeshPacket::serialize(packet, txFrame);
+    
+    if (txFrame.size() > RM_MAX_PACKET_SIZE) {
+        Serial.printf("[RADIO] Packet too large: %d bytes\n", txFrame.size());
+        updateStatistics(true, false, txFrame.size());
+        return false;
+    }
+    
+    // Broadcasts and floods go out on the control profile everyone hears
+    RadioProfile profile = linkProfiles.profileFor(packet.header.nextHop, packet.header.messageId);
+    bool scanning = linkProfiles.needsScan();
+    uint32_t airtimeMs = RealMeshLinkProfiles::airtimeMs(profile, txFrame.size(), scanning);
+    
+    // Hard stop at the regulatory limit even if the caller didn't ask first
+    if (!dutyCycle.canTransmit(airtimeMs, packet.header.priority)) {
+        return false;
+    }
+    
+    linkProfiles.recordTransmission(packet.header.nextHop, packet.header.messageId, profile);
+    
+    // Accept the frame and listen before talking; the result arrives via
+    // OnTransmitComplete once it has actually gone out (or been abandoned)
+    txBytes = txFrame.size();
+    txSourceId = packet.header.messageType == MSG_AGGREGATE ? 0 : packet.source.uuid.getShortId();
+    txMessageId = packet.header.messageId;
+    txProfile = profile;
+    txPreamble = RealMeshLinkProfiles::preambleLength(profile, scanning);
+    txAirtimeMs = airtimeMs;
+    transmitting = true;
+    cadAttempts = 0;
+    
+    Serial.printf("[RADIO] Sending packet: %s (%d bytes, %s)\n", 
+                 RealMeshPacket::packetToString(packet).c_str(), txFrame.size(),
+                 RealMeshLinkProfiles::params(profile).name);
+    
+    startChannelActivityDetection();
+    return true;
+}
+
+bool RealMeshRadio::canTransmit(const MessagePacket& packet) {
+    if (!initialized) {
+        return false;
+    }
+    
+    RadioLock lock(radioLock);
+    if (isBusy()) {
+        return false;
+    }
+    
+    RadioProfile profile = linkProfiles.profileFor(packet.header.nextHop, packet.header.messageId);
+    uint32_t airtimeMs = RealMeshLinkProfiles::airtimeMs(profile, RealMeshPacket::serializedSize(packet),
+                                                         linkProfiles.needsScan());
+    bool allowed = dutyCycle.canTransmit(airtimeMs, packet.header.priority);
+    
+    // Count each stretch of deferral once, not every poll
+    if (!allowed && !dutyCycleBlocked) {
+        dutyCycleDeferrals++;
+        Serial.printf("[RADIO] Duty cycle budget reached (%d%% used), deferring priority %d\n",
+                     dutyCycle.getUsagePercent(), packet.header.priority);
+    }
+    dutyCycleBlocked = !allowed;
+    
+    return allowed;
+}
+
+bool RealMeshRadio::cancelTransmit(uint16_t sourceShortId, uint32_t messageId) {
+    if (!initialized) return false;
+    
+    RadioLock lock(radioLock);
+    if (!transmitting || radioState != RADIO_BACKOFF || txSourceId == 0 ||
+        txSourceId != sourceShortId || txMessageId != messageId) {
+        return false;
+    }
+    
+    Serial.printf("[RADIO] Dropped frame %u while backing off\n", messageId);
+    transmitting = false;
+    startListening();
+    
+    if (transmitCallback) {
+        transmitCallback(false, "Cancelled");
+    }
+    return true;
+}
+
+void RealMeshRadio::processIncoming() {
+    if (!initialized) return;
+    
+    // A received frame is copied out under the lock and handed on after
+    // it is released, so routing it doesn't hold up the scan task
+    uint8_t frame[RM_MAX_PACKET_SIZE];
+    size_t frameLength = 0;
+    float rssi = 0;
+    float snr = 0;
+    
+    {
+        RadioLock lock(radioLock);
+        
+        // Received frames first - they also tell us the channel was busy
+        if (rxDoneFlag) {
+            rxDoneFlag = false;
+            frameLength = readReceivedPacket(rxTimestamp, frame, rssi, snr);
+        }
+        
+        updateChannelUtilization();
+        advanceState();
+    }
+    
+    if (frameLength > 0) {
+        deliverFrames(frame, frameLength, rssi, snr);
+    }
+}
+
+void RealMeshRadio::advanceState() {
+    switch (radioState) {
+        case RADIO_RX:
+            // A scan hit that never turned into a frame
+            if (rxLockUntil != 0 && (int32_t)(millis() - rxLockUntil) >= 0) {
+                startListening();
+            }
+            break;
+            
+        case RADIO_SCAN:
+            // Only without a scan task, or when the loop beat it to the lock
+            if (cadDoneFlag) {
+                cadDoneFlag = false;
+                handleScanResult();
+            } else if ((int32_t)(millis() - cadDeadline) >= 0) {
+                // A lost CadDone would otherwise end the scan for good
+                startListening();
+            }
+            break;
+            
+        case RADIO_CAD:
+            if (cadDoneFlag) {
+                cadDoneFlag = false;
+                handleChannelActivityResult();
+            } else if ((int32_t)(millis() - cadDeadline) >= 0) {
+                // CadDone never arrived; retry, and give up like a busy channel would
+                Serial.println("[RADIO] Channel scan timed out");
+                if (++cadAttempts >= RM_CAD_MAX_ATTEMPTS) {
+                    completeTransmit(RADIOLIB_ERR_TX_TIMEOUT);
+                } else {
+                    startChannelActivityDetection();
+                }
+            }
+            break;
+            
+        case RADIO_BACKOFF:
+            if ((int32_t)(millis() - backoffUntil) >= 0) {
+                startChannelActivityDetection();
+            }
+            break;
+            
+        case RADIO_TX:
+            if (txDoneFlag) {
+                txDoneFlag = false;
+                completeTransmit(RADIOLIB_ERR_NONE);
+            } else if (millis() - txStartTime > RM_TX_TIMEOUT_MS) {
+                completeTransmit(RADIOLIB_ERR_TX_TIMEOUT);
+            }
+            break;
+            
+        default:
+            break;
+    }
+}
+
+bool RealMeshRadio::isBusy() const {
+    // On air, holding a received frame not yet read out, or in the
+    // middle of receiving one a scan just found
+    return transmitting || rxDoneFlag || (radioState == RADIO_RX && rxLockUntil != 0);
+}
+
+bool RealMeshRadio::applyProfile(RadioProfile profile, bool inStandby) {
+    if (profile == currentProfile) return true;
+    
+    // A finished CAD leaves the chip in standby already. The preamble
+    // length only matters when sending, so scan steps write just the
+    // modulation that differs.
+    const RadioProfileParams& params = RealMeshLinkProfiles::params(profile);
+    if (!inStandby) {
+        radio.standby();
+    }
+    
+    int state = radio.setSpreadingFactor(params.spreadingFactor);
+    if (state == RADIOLIB_ERR_NONE && (currentProfile >= PROFILE_COUNT ||
+        RealMeshLinkProfiles::params(currentProfile).bandwidthKhz != params.bandwidthKhz)) {
+        state = radio.setBandwidth(params.bandwidthKhz);
+    }
+    
+    if (state != RADIOLIB_ERR_NONE) {
+        Serial.printf("[RADIO] Failed to switch to %s profile: %s\n", params.name, getRadioStateString(state).c_str());
+        currentProfile = PROFILE_COUNT; // Unknown - reapply next time
+        return false;
+    }
+    
+    currentProfile = profile;
+    return true;
+}
+
+bool RealMeshRadio::applyPreamble(uint16_t preambleLength) {
+    if (preambleLength == currentPreamble) return true;
     
-    if (data.size() > RM_MAX_PACKET_SIZE) {
-        Serial.printf("[RADIO] Packet too large: %d bytes\n", data.size());
-        updateStatistics(true, false, data.size());
+    radio.standby();
+    if (radio.setPreambleLength(preambleLength) != RADIOLIB_ERR_NONE) {
         return false;
     }
+    currentPreamble = preambleLength;
+    return true;
+}
+
+void RealMeshRadio::startListening(bool afterCad) {
+    receiving = true;
+    rxLockUntil = 0;
+    
+    if (linkProfiles.needsScan()) {
+        // CAD on the next profile in turn that some link uses (SLOW
+        // always); handleScanResult() moves on
+        do {
+            scanIndex = (scanIndex + 1) % PROFILE_COUNT;
+        } while (!linkProfiles.inUse((RadioProfile)scanIndex) && scanIndex != PROFILE_SLOW);
+        
+        cadDoneFlag = false;
+        radioState = RADIO_SCAN;
+        cadDeadline = millis() + cadTimeoutMs((RadioProfile)scanIndex);
+        
+        if (applyProfile((RadioProfile)scanIndex, afterCad) && radio.startChannelScan() == RADIOLIB_ERR_NONE) {
+            return;
+        }
+    }
     
-    // Stop receiving to transmit
+    // Continuous RX on the control profile
+    applyProfile(PROFILE_SLOW);
+    radioState = RADIO_RX;
+    radio.startReceive();
+}
+
+void RealMeshRadio::handleScanResult() {
+    if (radio.getChannelScanResult() != RADIOLIB_LORA_DETECTED) {
+        startListening(true);
+        return;
+    }
+    
+    // Someone is sending on this profile - receive for as long as the
+    // longest frame it can carry
+    rxLockUntil = millis() + RealMeshLinkProfiles::airtimeMs(currentProfile, RM_MAX_PACKET_SIZE, true);
+    if (rxLockUntil == 0) rxLockUntil = 1;
+    radioState = RADIO_RX;
+    radio.startReceive();
+}
+
+void RealMeshRadio::startChannelActivityDetection() {
+    // Listen before talk on the profile the frame will use
+    applyProfile(txProfile);
+    applyPreamble(txPreamble);
+    cadDoneFlag = false;
     receiving = false;
+    radioState = RADIO_CAD;
+    cadDeadline = millis() + cadTimeoutMs(txProfile);
+    
+    int state = radio.startChannelScan();
+    if (state != RADIOLIB_ERR_NONE) {
+        // CAD unavailable - fall back to transmitting blind
+        Serial.printf("[RADIO] Channel scan failed: %s\n", getRadioStateString(state).c_str());
+        beginTransmit();
+    }
+}
+
+void RealMeshRadio::handleChannelActivityResult() {
+    if (radio.getChannelScanResult() != RADIOLIB_LORA_DETECTED) {
+        beginTransmit();
+        return;
+    }
+    
+    channelDeferrals++;
+    cadAttempts++;
     
-    // Send the packet
-    int state = radio.transmit(data.data(), data.size());
+    if (cadAttempts >= RM_CAD_MAX_ATTEMPTS) {
+        Serial.printf("[RADIO] Channel busy after %d attempts, dropping frame\n", cadAttempts);
+        channelBusyDrops++;
+        completeTransmit(RADIOLIB_LORA_DETECTED);
+        return;
+    }
+    
+    // Binary exponential backoff with jitter so deferring nodes don't
+    // all come back at the same instant
+    uint8_t exponent = min(cadAttempts, (uint8_t)RM_CAD_BACKOFF_MAX_EXP);
+    uint32_t window = (uint32_t)RM_CAD_BACKOFF_SLOT_MS << exponent;
+    uint32_t backoff = random(RM_CAD_BACKOFF_SLOT_MS, window + 1);
+    backoffUntil = millis() + backoff;
+    backoffTime += backoff;
+    
+    // Keep listening while we wait - the busy channel is probably for us
+    radioState = RADIO_BACKOFF;
+    radio.startReceive();
+    receiving = true;
+}
+
+void RealMeshRadio::beginTransmit() {
+    // Flag first so the ISR attributes the next DIO1 edge to TX
+    txDoneFlag = false;
+    radioState = RADIO_TX;
+    txStartTime = millis();
+    
+    int state = radio.startTransmit(txFrame.data(), txFrame.size());
+    if (state != RADIOLIB_ERR_NONE) {
+        Serial.printf("[RADIO] Failed to send packet: %s\n", getRadioStateString(state).c_str());
+        completeTransmit(state);
+        return;
+    }
+    
+    // Charge the airtime once the frame is really going out. Failed starts
+    // and frames abandoned after CAD never reach here and cost nothing; a
+    // TX timeout is still charged, as the frame may have gone out
+    dutyCycle.recordTransmission(txAirtimeMs);
+}
+
+void RealMeshRadio::completeTransmit(int state) {
+    radio.finishTransmit();
+    
+    // Frames dropped before reaching TX never went on air
+    if (radioState == RADIO_TX) {
+        uint32_t airtime = millis() - txStartTime;
+        channelBusyTime += airtime;
+        txAirtime += airtime;
+    }
     
     bool success = (state == RADIOLIB_ERR_NONE);
-    updateStatistics(true, success, data.size());
+    updateStatistics(true, success, txBytes);
     
     if (success) {
-        Serial.printf("[RADIO] Sent packet: %s (%d bytes)\n", 
-                     RealMeshPacket::packetToString(packet).c_str(), data.size());
+        Serial.printf("[RADIO] Transmit complete (%d bytes, %u ms)\n", txBytes, (unsigned)(millis() - txStartTime));
         lastTransmission = millis();
     } else {
-        Serial.printf("[RADIO] Failed to send packet: %s\n", getRadioStateString(state).c_str());
         handleTransmitError(state);
     }
     
     // Resume receiving
-    radio.startReceive();
-    receiving = true;
+    transmitting = false;
+    startListening();
     
     // Call callback if set
     if (transmitCallback) {
         transmitCallback(success, success ? "OK" : getRadioStateString(state));
     }
-    
-    return success;
 }
 
-void RealMeshRadio::processIncoming() {
-    if (!initialized || !receiving) return;
+size_t RealMeshRadio::readReceivedPacket(uint32_t timestamp, uint8_t* data, float& rssi, float& snr) {
+    size_t length = radio.getPacketLength();
+    size_t readLength = length > 0 && length <= RM_MAX_PACKET_SIZE ? length : RM_MAX_PACKET_SIZE;
+    int state = radio.readData(data, readLength);
+    
+    // Get signal quality before the next reception overwrites it
+    rssi = radio.getRSSI();
+    snr = radio.getSNR();
+    
+    RadioProfile rxProfile = currentProfile;
+    
+    // Re-arm reception straight away; a backoff keeps its TX profile,
+    // and a CAD or TX that raced the frame is left alone
+    if (radioState == RADIO_BACKOFF) {
+        radio.startReceive();
+    } else if (radioState == RADIO_RX || radioState == RADIO_SCAN) {
+        startListening();
+    }
     
-    // Check if data is available (simpler approach)
-    // Read the packet directly - RadioLib handles IRQ internally
-    std::vector<uint8_t> data(RM_MAX_PACKET_SIZE);
-    int state = radio.readData(data.data(), data.size());
+    // Corrupted frames occupied the channel just the same
+    if (length > 0) {
+        uint32_t airtime = RealMeshLinkProfiles::airtimeMs(rxProfile, length);
+        channelBusyTime += airtime;
+        rxAirtime += airtime;
+    }
     
-    if (state > 0) {
-        // Successful reception
-        data.resize(state); // Trim to actual size
-        
-        // Get signal quality
-        float rssi = radio.getRSSI();
-        float snr = radio.getSNR();
-        
+    if (state == RADIOLIB_ERR_NONE && length > 0) {
         // Update statistics
-        updateStatistics(false, true, data.size());
+        updateStatistics(false, true, readLength);
         avgRSSI = (avgRSSI * 0.9) + (rssi * 0.1); // Running average
         avgSNR = (avgSNR * 0.9) + (snr * 0.1);
-        lastReception = millis();
+        lastReception = timestamp;
+        return readLength;
+    }
+    
+    // Handle reception errors (CRC mismatch etc.)
+    handleReceiveError(state);
+    return 0;
+}
+
+void RealMeshRadio::deliverFrames(const uint8_t* data, size_t length, float rssi, float snr) {
+    // An aggregate is handed on one member at a time, as if each had
+    // arrived on its own
+    if (RealMeshPacket::isAggregate(data, length)) {
+        size_t offset = 0;
+        const uint8_t* member;
+        size_t memberLength;
+        while (RealMeshPacket::nextAggregateMember(data, length, offset, member, memberLength)) {
+            deliverFrame(member, memberLength, rssi, snr);
+        }
+    } else {
+        deliverFrame(data, length, rssi, snr);
+    }
+}
+
+void RealMeshRadio::deliverFrame(const uint8_t* data, size_t length, float rssi, float snr) {
+    // Only the header is decoded here; the router decides whether the
+    // addresses are worth parsing
+    RealMeshPacketView frame(data, length);
+    if (!frame.isValid()) {
+        Serial.printf("[RADIO] Failed to deserialize packet (%d bytes)\n", length);
+        RadioLock lock(radioLock);
+        receiveErrors++;
+        return;
+    }
+    
+    Serial.printf("[RADIO] Received frame: ID %08X, type %d, hops %d/%d, %d bytes (RSSI: %.1fdBm, SNR: %.1fdB)\n",
+                 frame.header().messageId, frame.header().messageType,
+                 frame.header().hopCount, frame.header().maxHops, length, rssi, snr);
+    
+    {
+        RadioLock lock(radioLock);
+        linkProfiles.recordReception(frame.transmitterShortId(), snr);
         
-        // Deserialize packet
-        MessagePacket packet;
-        if (RealMeshPacket::deserialize(data, packet)) {
-            Serial.printf("[RADIO] Received packet: %s (RSSI: %.1fdBm, SNR: %.1fdB)\n",
-                         RealMeshPacket::packetToString(packet).c_str(), rssi, snr);
-            
-            // Call callback if set
-            if (messageCallback) {
-                messageCallback(packet, (int16_t)rssi, snr);
-            }
-        } else {
-            Serial.printf("[RADIO] Failed to deserialize packet (%d bytes)\n", data.size());
-            receiveErrors++;
+        // First link on a faster profile: start scanning. The frame just
+        // ended, so continuous RX isn't in the middle of another one.
+        if (radioState == RADIO_RX && rxLockUntil == 0 && linkProfiles.needsScan()) {
+            startListening();
         }
-    } else if (state != RADIOLIB_ERR_RX_TIMEOUT && state != RADIOLIB_ERR_NONE) {
-        // Handle reception errors (ignore timeouts and "no data" as they're normal)
-        handleReceiveError(state);
+    }
+    
+    // Call callback if set
+    if (messageCallback) {
+        messageCallback(frame, (int16_t)rssi, snr);
     }
 }
 
+uint32_t RealMeshRadio::getAirtimeMs(uint16_t shortId, size_t bytes) const {
+    return RealMeshLinkProfiles::airtimeMs(linkProfiles.profileFor(shortId), bytes, linkProfiles.needsScan());
+}
+
 void RealMeshRadio::setOnMessageReceived(OnMessageReceived callback) {
     messageCallback = callback;
 }
@@ -280,25 +722,50 @@ void RealMeshRadio::setOnTransmitComplete(OnTransmitComplete callback) {
 
 float RealMeshRadio::getCurrentRSSI() {
     if (!initialized) return -999.0;
+    RadioLock lock(radioLock);
     return radio.getRSSI();
 }
 
 float RealMeshRadio::getCurrentSNR() {
     if (!initialized) return -999.0;
+    RadioLock lock(radioLock);
     return radio.getSNR();
 }
 
 bool RealMeshRadio::isChannelBusy() {
     if (!initialized) return false;
-    
-    // Simple RSSI-based channel activity detection
-    float rssi = getCurrentRSSI();
-    return rssi > -90.0; // Threshold for "busy" channel
+    RadioLock lock(radioLock);
+    if (isBusy()) return true;
+    
+    // Channel Activity Detection finds LoRa preambles below the noise floor,
+    // which an RSSI threshold misses
+    bool busy = radio.scanChannel() == RADIOLIB_LORA_DETECTED;
+    startListening();
+    return busy;
 }
 
 float RealMeshRadio::getChannelUtilization() {
-    if (channelSampleTime == 0) return 0.0;
-    return (float)channelBusyTime / channelSampleTime * 100.0;
+    return channelUtilization;
+}
+
+void RealMeshRadio::startChannelScan(uint32_t duration) {
+    channelSampleWindow = max(duration, (uint32_t)1000);
+    channelSampleTime = millis();
+    channelBusyTime = 0;
+    
+    Serial.printf("[RADIO] Sampling channel utilization every %u ms\n", channelSampleWindow);
+}
+
+void RealMeshRadio::updateChannelUtilization() {
+    uint32_t elapsed = millis() - channelSampleTime;
+    if (elapsed < channelSampleWindow) return;
+    
+    // Long frames can straddle a window boundary, so clamp each sample
+    float sample = min((float)channelBusyTime / elapsed * 100.0f, 100.0f);
+    channelUtilization = (channelUtilization * 0.75f) + (sample * 0.25f);
+    
+    channelBusyTime = 0;
+    channelSampleTime = millis();
 }
 
 void RealMeshRadio::printRadioConfig() {
@@ -313,7 +780,9 @@ void RealMeshRadio::printRadioConfig() {
     Serial.printf("  Spreading Factor: SF%d\n", RM_SPREADING_FACTOR);
     Serial.printf("  Coding Rate: 4/%d\n", RM_CODING_RATE);
     Serial.printf("  TX Power: %d dBm\n", RM_TX_POWER_DBM);
-    Serial.printf("  Preamble Length: %d symbols\n", RM_PREAMBLE_LENGTH);
+    Serial.printf("  Preamble Length: %d symbols (%d while scanning)\n", RM_PREAMBLE_LENGTH, RM_PROFILE_SLOW_PREAMBLE);
+    Serial.printf("  Link Profiles: %s\n", RM_ADR_ENABLED ? "FAST/MEDIUM/SLOW by link SNR" : "SLOW only");
+    Serial.printf("  Duty Cycle Budget: %u ms per %u s\n", dutyCycle.getBudget(), RM_DUTY_CYCLE_WINDOW_MS / 1000);
     Serial.printf("  Sync Word: 0x%02X\n", RM_SYNC_WORD);
     Serial.printf("  Current RSSI: %.1f dBm\n", getCurrentRSSI());
     Serial.printf("  Current SNR: %.1f dB\n", getCurrentSNR());
@@ -321,6 +790,7 @@ void RealMeshRadio::printRadioConfig() {
     Serial.printf("  Messages Received: %d\n", messagesReceived);
     Serial.printf("  Transmit Errors: %d\n", transmitErrors);
     Serial.printf("  Receive Errors: %d\n", receiveErrors);
+    Serial.printf("  Channel Deferrals: %d (dropped busy: %d)\n", channelDeferrals, channelBusyDrops);
 }
 
 void RealMeshRadio::runRadioTest() {
@@ -408,19 +878,62 @@ String RealMeshRadio::getRadioStateString(int state) {
         case RADIOLIB_ERR_INVALID_CODING_RATE: return "Invalid coding rate";
         case RADIOLIB_ERR_INVALID_FREQUENCY: return "Invalid frequency";
         case RADIOLIB_ERR_INVALID_OUTPUT_POWER: return "Invalid output power";
+        case RADIOLIB_LORA_DETECTED: return "Channel busy";
         default: return "Error code " + String(state);
     }
 }
 
 // Static interrupt handlers
-void RealMeshRadio::onTransmitDone() {
-    if (instance) {
-        // Handle in main loop
+void IRAM_ATTR RealMeshRadio::onDio1Interrupt() {
+    if (!instance) return;
+    
+    // DIO1 carries all events; our own state says which one this is
+    switch (instance->radioState) {
+        case RADIO_TX:
+            onTransmitDone();
+            break;
+        case RADIO_SCAN:
+        case RADIO_CAD:
+            onChannelScanDone();
+            break;
+        default:
+            onReceiveDone();
+            break;
     }
 }
 
-void RealMeshRadio::onReceiveDone() {
-    if (instance) {
-        // Handle in main loop via processIncoming()
+void IRAM_ATTR RealMeshRadio::onTransmitDone() {
+    // Handle in main loop via processIncoming()
+    instance->txDoneFlag = true;
+}
+
+void IRAM_ATTR RealMeshRadio::onChannelScanDone() {
+    instance->cadDoneFlag = true;
+    
+    if (instance->radioState == RADIO_SCAN && instance->scanTask) {
+        BaseType_t woken = pdFALSE;
+        vTaskNotifyGiveFromISR(instance->scanTask, &woken);
+        if (woken) portYIELD_FROM_ISR();
     }
-}
\ No newline at end of file
+}
+
+void IRAM_ATTR RealMeshRadio::onReceiveDone() {
+    // Timestamp here - the loop may get to the packet much later
+    instance->rxTimestamp = millis();
+    instance->rxDoneFlag = true;
+}
+
+void RealMeshRadio::runScanTask(void* arg) {
+    RealMeshRadio* self = static_cast<RealMeshRadio*>(arg);
+    
+    for (;;) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        
+        // The loop may have moved on to a transmission meanwhile
+        RadioLock lock(self->radioLock);
+        if (self->initialized && self->radioState == RADIO_SCAN && self->cadDoneFlag) {
+            self->cadDoneFlag = false;
+            self->handleScanResult();
+        }
+    }
+}
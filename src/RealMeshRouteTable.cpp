@@ -0,0 +1,141 @@
+#include "RealMeshRouteTable.h"
+#include "RealMeshConfig.h"
+
+// ============================================================================
+// Fixed-Capacity Routing Table Implementation
+// ============================================================================
+
+static_assert((RM_ROUTE_TABLE_SLOTS & (RM_ROUTE_TABLE_SLOTS - 1)) == 0,
+              "RM_ROUTE_TABLE_SLOTS must be a power of two");
+static_assert(RM_ROUTE_TABLE_SLOTS >= 2 * RM_MAX_ROUTING_ENTRIES,
+              "RM_ROUTE_TABLE_SLOTS must be at least twice RM_MAX_ROUTING_ENTRIES");
+static_assert(RM_MAX_ROUTING_ENTRIES < 0xFFFE,
+              "RM_MAX_ROUTING_ENTRIES must fit in a 16-bit slot index");
+
+RealMeshRouteTable::RealMeshRouteTable() :
+    count(0),
+    deletedSlots(0) {
+    
+    for (size_t i = 0; i < RM_ROUTE_TABLE_SLOTS; i++) {
+        slots[i].destination = RM_INVALID_ADDRESS;
+        slots[i].index = SLOT_EMPTY;
+    }
+}
+
+RoutingEntry* RealMeshRouteTable::find(AddressHandle destination) {
+    int slot = findSlot(destination);
+    return slot >= 0 ? &entries[slots[slot].index] : nullptr;
+}
+
+RoutingEntry* RealMeshRouteTable::insert(AddressHandle destination) {
+    int existing = findSlot(destination);
+    if (existing >= 0) {
+        return &entries[slots[existing].index];
+    }
+    
+    if (destination == RM_INVALID_ADDRESS || count >= RM_MAX_ROUTING_ENTRIES) {
+        return nullptr;
+    }
+    
+    // Too many tombstones lengthen probe chains - compact the index first
+    if (count + deletedSlots >= (RM_ROUTE_TABLE_SLOTS * 3) / 4) {
+        rebuildIndex();
+    }
+    
+    uint32_t mask = RM_ROUTE_TABLE_SLOTS - 1;
+    uint32_t pos = slotFor(destination);
+    while (slots[pos].index != SLOT_EMPTY && slots[pos].index != SLOT_DELETED) {
+        pos = (pos + 1) & mask;
+    }
+    
+    if (slots[pos].index == SLOT_DELETED) {
+        deletedSlots--;
+    }
+    
+    uint16_t index = count++;
+    slots[pos].destination = destination;
+    slots[pos].index = index;
+    
+    RoutingEntry& entry = entries[index];
+    entry = RoutingEntry();
+    entry.destination = destination;
+    entry.nextHop = RM_INVALID_ADDRESS;
+    entry.backupHop = RM_INVALID_ADDRESS;
+    return &entry;
+}
+
+bool RealMeshRouteTable::remove(AddressHandle destination) {
+    int slot = findSlot(destination);
+    if (slot < 0) {
+        return false;
+    }
+    
+    uint16_t index = slots[slot].index;
+    slots[slot].index = SLOT_DELETED;
+    deletedSlots++;
+    
+    // Keep the pool dense by moving the last entry into the hole
+    uint16_t last = count - 1;
+    if (index != last) {
+        int lastSlot = findSlot(entries[last].destination);
+        entries[index] = entries[last];
+        if (lastSlot >= 0) {
+            slots[lastSlot].index = index;
+        }
+    }
+    
+    count--;
+    return true;
+}
+
+void RealMeshRouteTable::clear() {
+    for (size_t i = 0; i < RM_ROUTE_TABLE_SLOTS; i++) {
+        slots[i].index = SLOT_EMPTY;
+    }
+    count = 0;
+    deletedSlots = 0;
+}
+
+// Private helpers
+
+uint32_t RealMeshRouteTable::slotFor(AddressHandle destination) {
+    // Fibonacci hashing spreads sequential handles across the index
+    return ((uint32_t)destination * 2654435769u >> 16) & (RM_ROUTE_TABLE_SLOTS - 1);
+}
+
+int RealMeshRouteTable::findSlot(AddressHandle destination) const {
+    uint32_t mask = RM_ROUTE_TABLE_SLOTS - 1;
+    uint32_t pos = slotFor(destination);
+    
+    for (size_t probes = 0; probes < RM_ROUTE_TABLE_SLOTS; probes++) {
+        const Slot& slot = slots[pos];
+        if (slot.index == SLOT_EMPTY) {
+            return -1;
+        }
+        if (slot.index != SLOT_DELETED && slot.destination == destination) {
+            return (int)pos;
+        }
+        pos = (pos + 1) & mask;
+    }
+    
+    return -1;
+}
+
+void RealMeshRouteTable::rebuildIndex() {
+    uint32_t mask = RM_ROUTE_TABLE_SLOTS - 1;
+    
+    for (size_t i = 0; i < RM_ROUTE_TABLE_SLOTS; i++) {
+        slots[i].index = SLOT_EMPTY;
+    }
+    
+    for (uint16_t i = 0; i < count; i++) {
+        uint32_t pos = slotFor(entries[i].destination);
+        while (slots[pos].index != SLOT_EMPTY) {
+            pos = (pos + 1) & mask;
+        }
+        slots[pos].destination = entries[i].destination;
+        slots[pos].index = i;
+    }
+    
+    deletedSlots = 0;
+}
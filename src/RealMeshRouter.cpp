@@ -1,5 +1,7 @@
 #include "RealMeshRouter.h"
 #include "RealMeshConfig.h"
+#include "RealMeshAirtime.h"
+#include "RealMeshCompression.h"
 #include <ArduinoJson.h>
 #include <vector>
 #include <map>
@@ -11,16 +13,44 @@
 
 RealMeshRouter::RealMeshRouter(const NodeAddress& ownAddress) :
     ownAddress(ownAddress),
+    ownHandle(RM_INVALID_ADDRESS),
     ownStatus(NODE_MOBILE),
-    lastHeartbeat(0),
-    lastRoutingTableCleanup(0),
+    lastMessageId(0),
+    seenCacheHead(0),
+    seenCacheCount(0),
     sendCallback(nullptr),
     messageCallback(nullptr),
-    routeCallback(nullptr) {
+    routeCallback(nullptr),
+    deliveryCallback(nullptr),
+    canSendCallback(nullptr),
+    airtimeCallback(nullptr),
+    reassembledCallback(nullptr),
+    cancelSendCallback(nullptr),
+    costFunction(nullptr),
+    lastHeartbeat(0),
+    heartbeatInterval(RM_HEARTBEAT_IMIN),
+    heartbeatIntervalStart(0),
+    heartbeatSendAt(0),
+    heartbeatsHeard(0),
+    heartbeatDecided(false),
+    heartbeatsSinceFull(RM_HEARTBEAT_FULL_EVERY),
+    lastRoutingTableCleanup(0) {
+    
+    metricPolicy.hopWeight = RM_METRIC_WEIGHT_HOPS;
+    metricPolicy.etxWeight = RM_METRIC_WEIGHT_ETX;
+    metricPolicy.latencyWeight = RM_METRIC_WEIGHT_LATENCY;
+    metricPolicy.preferenceWeight = RM_METRIC_WEIGHT_PREFERENCE;
     
     // Initialize network stats
     stats = {};
     stats.lastHeartbeat = millis();
+    
+    // Initialize duplicate suppression cache
+    memset(seenCache, 0, sizeof(seenCache));
+    memset(seenFilter, 0, sizeof(seenFilter));
+    memset(&lastAnnounced, 0, sizeof(lastAnnounced));
+    
+    ownHandle = addresses.intern(ownAddress);
 }
 
 bool RealMeshRouter::begin() {
@@ -29,49 +59,154 @@ bool RealMeshRouter::begin() {
     // Initialize our own subdomain info
     SubdomainInfo& ourSubdomain = subdomains[ownAddress.subdomain];
     ourSubdomain.subdomainName = ownAddress.subdomain;
-    ourSubdomain.knownNodes.push_back(ownAddress);
+    ourSubdomain.knownNodes.push_back(ownHandle);
     ourSubdomain.lastUpdated = millis();
     ourSubdomain.isLocal = true;
     
     // If we're stationary, add ourselves as a hub
     if (ownStatus == NODE_STATIONARY) {
-        addStationaryHub(ownAddress);
+        addStationaryHub(ownHandle);
     }
     
+    startHeartbeatInterval(RM_HEARTBEAT_IMIN);
+    
+    // v2 frames carry address hashes; names come from what we've learned
+    RealMeshPacket::setAddressResolvers(
+        [this](uint32_t hash, uint16_t shortId, NodeAddress& address) { return resolveNode(hash, shortId, address); },
+        [this](uint16_t hash, String& subdomain) { return resolveSubdomain(hash, subdomain); });
+    
     Serial.println("[ROUTER] Routing engine started successfully");
     return true;
 }
 
-bool RealMeshRouter::processIncomingPacket(const MessagePacket& packet, int16_t rssi, float snr) {
-    if (!isValidPacket(packet)) {
+bool RealMeshRouter::processIncomingFrame(const RealMeshPacketView& frame, int16_t rssi, float snr) {
+    const MessageHeader& header = frame.header();
+    uint16_t sourceId = frame.sourceShortId();
+    
+    if (!frame.isValid() || sourceId == 0 || header.payloadLength > RM_MAX_PAYLOAD_SIZE ||
+        header.hopCount > header.maxHops) {
+        Serial.println("[ROUTER] Invalid packet received");
+        return false;
+    }
+    
+    // Every frame measures the link to whoever transmitted it, duplicates
+    // included; only the originator's own frames carry its sequence
+    uint16_t transmitter = frame.transmitterShortId();
+    if (transmitter != ownAddress.uuid.getShortId()) {
+        if (neighbors.recordFrame(transmitter, rssi, snr, transmitter == sourceId, header.sequenceNumber)) {
+            resetHeartbeatTimer("new neighbor");
+        } else if (header.messageType == MSG_HEARTBEAT && transmitter == sourceId &&
+                   heartbeatsHeard < UINT8_MAX) {
+            heartbeatsHeard++; // A known neighbor announcing itself counts as consistent
+        }
+    }
+    
+    // Drop flood copies and echoes of our own packets before decoding them
+    if (isDuplicatePacket(sourceId, header.messageId)) {
+        noteOverheardCopy(sourceId, header.messageId);
+        
+        // Retries reuse the messageId: re-ACK data we already delivered
+        // (a repeated last fragment asks for a NACK), and relay again if
+        // the sender picked us as next hop or flooded a newer retry
+        bool deliveredHere = (header.messageType == MSG_DATA || header.messageType == MSG_FRAGMENT) &&
+                             frame.isAddressedTo(ownAddress);
+        bool relayViaUs = (header.routingFlags & ROUTE_DIRECT) && header.nextHop == ownAddress.uuid.getShortId();
+        uint8_t retry = RM_ROUTE_RETRY(header.routingFlags);
+        bool newerFlood = (header.routingFlags & ROUTE_FLOOD) &&
+                          !isDuplicatePacket(sourceId, header.messageId, retry);
+        PacketHandle packet;
+        if ((deliveredHere || relayViaUs || newerFlood) &&
+            (packet = RealMeshPacketPool::acquire()) && frame.decode(*packet)) {
+            if (deliveredHere && header.messageType == MSG_FRAGMENT) {
+                handleFragmentMessage(*packet);
+                return false;
+            }
+            if (deliveredHere) {
+                // Only what was delivered the first time is acknowledged again
+                if (payloadDecodes(*packet)) {
+                    sendAck(*packet, header.messageId);
+                }
+                return false;
+            }
+            if (newerFlood) {
+                rememberPacket(sourceId, header.messageId, retry);
+            }
+            return shouldForwardPacket(std::move(packet), snr);
+        }
+        
+        // Only copies we do nothing with count as dropped
+        stats.messagesDropped++;
+        return false;
+    }
+    
+    // Decoded straight into a pool slot that a relay can queue as is
+    PacketHandle packet = RealMeshPacketPool::acquire();
+    if (!packet) {
+        Serial.println("[ROUTER] Packet pool exhausted, frame dropped");
+        stats.messagesDropped++;
+        return false;
+    }
+    
+    if (!frame.decode(*packet) || !isValidPacket(*packet)) {
         Serial.println("[ROUTER] Invalid packet received");
         return false;
     }
     
+    // An echo of ours that outlived the seen cache
+    if (packet->source.uuid == ownAddress.uuid) {
+        stats.messagesDropped++;
+        return false;
+    }
+    rememberPacket(sourceId, header.messageId, RM_ROUTE_RETRY(header.routingFlags));
+    
+    return handleIncomingPacket(std::move(packet), rssi, snr);
+}
+
+bool RealMeshRouter::handleIncomingPacket(PacketHandle handle, int16_t rssi, float snr) {
+    const MessagePacket& packet = *handle;
+    
     // Update statistics
     stats.messagesReceived++;
     stats.avgRSSI = (stats.avgRSSI * 0.9f) + (rssi * 0.1f);
     
     // Learn route from this packet if it's not from us
-    if (packet.source.getFullAddress() != ownAddress.getFullAddress()) {
-        updatePathFromPacket(packet, rssi);
+    AddressHandle source = internAddress(packet.source);
+    if (source != RM_INVALID_ADDRESS && source != ownHandle) {
+        updatePathFromPacket(packet, source, rssi);
+    }
+    
+    // Every node that hears a route reply learns the advertised route too
+    if (packet.header.messageType == MSG_ROUTE_REPLY) {
+        learnFromRouteReply(packet, rssi);
     }
     
     // Check if packet is for us
     if (isPacketForUs(packet)) {
+        // Broadcasts are delivered here and still relayed to the rest of the mesh
+        if (packet.destination.nodeId.isEmpty() && (packet.header.routingFlags & ROUTE_FLOOD)) {
+            shouldForwardPacket(handle, snr);
+        }
+        
         // Handle different message types
         switch (packet.header.messageType) {
             case MSG_DATA:
                 return handleDataMessage(packet, rssi);
             case MSG_CONTROL:
+                return handleControlMessage(packet, rssi);
             case MSG_ROUTE_REQUEST:
+                handleRouteRequest(packet);
+                return false;
             case MSG_ROUTE_REPLY:
-                return handleControlMessage(packet, rssi);
+                handleRouteReply(packet);
+                return false;
             case MSG_HEARTBEAT:
                 return handleHeartbeatMessage(packet, rssi);
+            case MSG_FRAGMENT:
+                return handleFragmentMessage(packet);
             case MSG_ACK:
-            case MSG_NACK:
                 return handleAckMessage(packet, rssi);
+            case MSG_NACK:
+                return handleNackMessage(packet, rssi);
             case MSG_NAME_CONFLICT:
                 return handleNameConflictMessage(packet, rssi);
             default:
@@ -81,7 +216,15 @@ bool RealMeshRouter::processIncomingPacket(const MessagePacket& packet, int16_t
     }
     
     // Check if we should forward this packet
-    return shouldForwardPacket(packet);
+    return shouldForwardPacket(std::move(handle), snr);
+}
+
+void RealMeshRouter::loop() {
+    processRebroadcasts();
+    processRouteDiscoveries();
+    processOutstandingMessages();
+    processFragments();
+    processTransmitQueue();
 }
 
 bool RealMeshRouter::routeMessage(const NodeAddress& destination, const String& message, MessagePriority priority) {
@@ -90,12 +233,44 @@ bool RealMeshRouter::routeMessage(const NodeAddress& destination, const String&
         return false;
     }
     
+    // Longer than one frame: send it in fragments
+    if (message.length() > RM_MAX_PAYLOAD_SIZE - 1 ||
+        frameOverhead(MSG_DATA, destination) + message.length() > RM_MAX_PACKET_SIZE) {
+        return fragmentMessage(destination, message, priority);
+    }
+    
     // Create data packet
-    MessagePacket packet = RealMeshPacket::createDataPacket(ownAddress, destination, message, priority);
+    PacketHandle packet = RealMeshPacketPool::acquire(
+        RealMeshPacket::createDataPacket(ownAddress, destination, message, priority));
+    if (!packet) {
+        Serial.println("[ROUTER] Packet pool exhausted, message not sent");
+        stats.messagesDropped++;
+        return false;
+    }
+    
+    lastMessageId = packet->header.messageId;
     
     Serial.printf("[ROUTER] Routing message to %s: %s\n", 
                  destination.getFullAddress().c_str(), message.c_str());
     
+    // Retries start from the untouched packet; routing detaches its own
+    // copy of the slot before rewriting the header
+    PacketHandle original;
+    if (destination.isValid()) {
+        original = packet;
+    }
+    if (dispatchPacket(packet)) {
+        if (original) {
+            trackDelivery(original, packet->header.routingFlags);
+        }
+        return true;
+    }
+    
+    Serial.printf("[ROUTER] Failed to route message to %s\n", destination.getFullAddress().c_str());
+    return false;
+}
+
+bool RealMeshRouter::dispatchPacket(PacketHandle& packet) {
     // Try different routing strategies in order
     if (routePacketDirect(packet)) {
         return true;
@@ -105,12 +280,12 @@ bool RealMeshRouter::routeMessage(const NodeAddress& destination, const String&
         return true;
     }
     
-    if (routePacketFlood(packet)) {
+    // Unknown unicast destination: ask for a route once instead of flooding the data
+    if (packet->destination.isValid() && bufferForDiscovery(packet)) {
         return true;
     }
     
-    Serial.printf("[ROUTER] Failed to route message to %s\n", destination.getFullAddress().c_str());
-    return false;
+    return routePacketFlood(packet);
 }
 
 bool RealMeshRouter::sendDirectMessage(const NodeAddress& destination, const String& message) {
@@ -128,13 +303,45 @@ bool RealMeshRouter::sendEmergencyMessage(const String& message) {
 }
 
 bool RealMeshRouter::sendHeartbeat() {
-    // Allow heartbeats every 3 seconds during initial discovery, then use normal intervals
-    uint32_t minInterval = (millis() < 60000) ? 3000 : (ownStatus == NODE_STATIONARY ? RM_HEARTBEAT_STATIONARY : RM_HEARTBEAT_MOBILE);
+    // Trickle (RFC 6206): the interval doubles up to the maximum while the
+    // neighborhood stays consistent; each interval has one chance to send
+    uint32_t elapsed = millis() - heartbeatIntervalStart;
+    
+    if (elapsed >= heartbeatInterval) {
+        startHeartbeatInterval(min(heartbeatInterval * 2, maxHeartbeatInterval()));
+        return true;
+    }
+    
+    if (heartbeatDecided || elapsed < heartbeatSendAt) {
+        return true; // Not our turn yet in this interval
+    }
+    heartbeatDecided = true;
+    
+    // Enough neighbors already said the same; stay quiet unless we've been
+    // silent long enough for routes towards us to start going stale
+    if (heartbeatsHeard >= RM_HEARTBEAT_REDUNDANCY && lastHeartbeat != 0 &&
+        millis() - lastHeartbeat < RM_HEARTBEAT_MAX_SILENCE) {
+        stats.heartbeatsSuppressed++;
+        Serial.printf("[ROUTER] Heartbeat suppressed (%d heard, interval %us)\n",
+                     heartbeatsHeard, heartbeatInterval / 1000);
+        return true;
+    }
     
-    if (millis() - lastHeartbeat < minInterval) {
-        return true; // Too soon for another heartbeat
+    return transmitHeartbeat();
+}
+
+void RealMeshRouter::resetHeartbeatTimer(const char* reason) {
+    // Already at the shortest interval: the pending heartbeat covers it
+    if (heartbeatInterval <= RM_HEARTBEAT_IMIN) {
+        return;
     }
     
+    Serial.printf("[ROUTER] Heartbeat interval reset (%s)\n", reason);
+    startHeartbeatInterval(RM_HEARTBEAT_IMIN);
+    heartbeatsSinceFull = RM_HEARTBEAT_FULL_EVERY; // New listeners need every field
+}
+
+bool RealMeshRouter::transmitHeartbeat() {
     // Prepare heartbeat data
     HeartbeatData heartbeat;
     heartbeat.sender = ownAddress;
@@ -149,107 +356,203 @@ bool RealMeshRouter::sendHeartbeat() {
     
     // Add bridged subdomains
     for (const auto& entry : intermediaryMemory) {
-        if (entry.isActive && entry.nodeA.subdomain != entry.nodeB.subdomain) {
-            String bridgedDomain = entry.nodeA.subdomain == ownAddress.subdomain ? 
-                                  entry.nodeB.subdomain : entry.nodeA.subdomain;
+        const NodeAddress& nodeA = addresses.get(entry.nodeA);
+        const NodeAddress& nodeB = addresses.get(entry.nodeB);
+        if (entry.isActive && nodeA.subdomain != nodeB.subdomain) {
+            String bridgedDomain = nodeA.subdomain == ownAddress.subdomain ? 
+                                  nodeB.subdomain : nodeA.subdomain;
             if (std::find(heartbeat.bridgedSubdomains.begin(), heartbeat.bridgedSubdomains.end(), bridgedDomain) == heartbeat.bridgedSubdomains.end()) {
                 heartbeat.bridgedSubdomains.push_back(bridgedDomain);
             }
         }
     }
     
-    // Create and send heartbeat packet
-    MessagePacket packet = RealMeshPacket::createHeartbeatPacket(ownAddress, heartbeat);
+    // Create and send heartbeat packet with only what changed since the last one
+    HeartbeatSummary summary = RealMeshPacket::summarizeHeartbeat(heartbeat);
+    uint8_t fields = changedHeartbeatFields(summary);
+    MessagePacket packet = RealMeshPacket::createHeartbeatPacket(ownAddress, heartbeat, fields);
     
-    if (sendCallback && sendCallback(packet)) {
+    if (enqueuePacket(packet)) {
+        lastAnnounced = summary;
         lastHeartbeat = millis();
         stats.lastHeartbeat = lastHeartbeat;
         stats.messagesSent++;
-        Serial.printf("[ROUTER] Sent heartbeat (status: %d, contacts: %d, bridges: %d)\n", 
-                     ownStatus, heartbeat.directContacts.size(), heartbeat.bridgedSubdomains.size());
+        Serial.printf("[ROUTER] Sent heartbeat (status: %d, contacts: %d, bridges: %d, fields: 0x%02X, %d bytes)\n", 
+                     ownStatus, heartbeat.directContacts.size(), heartbeat.bridgedSubdomains.size(),
+                     fields, packet.header.payloadLength);
         return true;
     }
     
     return false;
 }
 
-void RealMeshRouter::addRoute(const NodeAddress& destination, const NodeAddress& nextHop, uint8_t hopCount) {
-    String key = addressToKey(destination);
-    
-    RoutingEntry& entry = routingTable[key];
-    entry.destination = destination;
-    entry.nextHop = nextHop;
-    entry.hopCount = hopCount;
-    entry.lastUsed = millis();
-    entry.signalStrength = 0; // Will be updated on first use
-    entry.reliability = 100;   // Start optimistic
-    entry.isValid = true;
+void RealMeshRouter::startHeartbeatInterval(uint32_t interval) {
+    heartbeatInterval = interval;
+    heartbeatIntervalStart = millis();
+    heartbeatSendAt = interval / 2 + random(interval / 2);
+    heartbeatsHeard = 0;
+    heartbeatDecided = false;
+}
+
+uint32_t RealMeshRouter::maxHeartbeatInterval() const {
+    return ownStatus == NODE_STATIONARY ? RM_HEARTBEAT_STATIONARY : RM_HEARTBEAT_MOBILE;
+}
+
+uint8_t RealMeshRouter::changedHeartbeatFields(const HeartbeatSummary& current) {
+    // Periodically send everything so listeners that missed a delta catch up
+    if (++heartbeatsSinceFull >= RM_HEARTBEAT_FULL_EVERY) {
+        heartbeatsSinceFull = 0;
+        return HB_FIELD_ALL;
+    }
     
-    Serial.printf("[ROUTER] Added route: %s -> %s (hops: %d)\n",
-                 destination.getFullAddress().c_str(),
-                 nextHop.getFullAddress().c_str(),
-                 hopCount);
+    // Uptime always goes out so listeners can tell when we restart
+    uint8_t fields = HB_FIELD_UPTIME;
+    if (current.status != lastAnnounced.status) fields |= HB_FIELD_STATUS;
+    if (current.directContacts != lastAnnounced.directContacts) fields |= HB_FIELD_CONTACTS;
+    if (current.bridgedSubdomains != lastAnnounced.bridgedSubdomains) fields |= HB_FIELD_BRIDGES;
+    if (current.messagesSent != lastAnnounced.messagesSent) fields |= HB_FIELD_SENT;
+    if (current.messagesReceived != lastAnnounced.messagesReceived) fields |= HB_FIELD_RECEIVED;
+    if (current.avgRSSI != lastAnnounced.avgRSSI) fields |= HB_FIELD_RSSI;
+    if (current.networkLoad != lastAnnounced.networkLoad) fields |= HB_FIELD_LOAD;
+    return fields;
+}
+
+void RealMeshRouter::rememberHeartbeat(AddressHandle source, const HeartbeatSummary& heartbeat) {
+    auto it = nodeHeartbeats.find(source);
+    if (it == nodeHeartbeats.end()) {
+        // Make room by forgetting the node heard from least recently
+        if (nodeHeartbeats.size() >= RM_HEARTBEAT_MAX_NODES) {
+            auto oldest = nodeHeartbeats.begin();
+            for (auto candidate = nodeHeartbeats.begin(); candidate != nodeHeartbeats.end(); ++candidate) {
+                if (millis() - candidate->second.lastHeard > millis() - oldest->second.lastHeard) {
+                    oldest = candidate;
+                }
+            }
+            nodeHeartbeats.erase(oldest);
+        }
+        it = nodeHeartbeats.insert(std::make_pair(source, HeartbeatSummary())).first;
+        memset(&it->second, 0, sizeof(HeartbeatSummary));
+    }
     
-    if (routeCallback) {
-        routeCallback("Route added: " + destination.getFullAddress());
+    // Fields left out of a delta keep their previous value
+    HeartbeatSummary& known = it->second;
+    uint8_t fields = heartbeat.fields;
+    if (fields & HB_FIELD_UPTIME && (known.fields & HB_FIELD_UPTIME) &&
+        heartbeat.uptimeSeconds < known.uptimeSeconds) {
+        Serial.printf("[ROUTER] %s restarted\n", addresses.nameOf(source).c_str());
     }
+    if (fields & HB_FIELD_STATUS) known.status = heartbeat.status;
+    if (fields & HB_FIELD_UPTIME) known.uptimeSeconds = heartbeat.uptimeSeconds;
+    if (fields & HB_FIELD_CONTACTS) known.directContacts = heartbeat.directContacts;
+    if (fields & HB_FIELD_BRIDGES) known.bridgedSubdomains = heartbeat.bridgedSubdomains;
+    if (fields & HB_FIELD_SENT) known.messagesSent = heartbeat.messagesSent;
+    if (fields & HB_FIELD_RECEIVED) known.messagesReceived = heartbeat.messagesReceived;
+    if (fields & HB_FIELD_RSSI) known.avgRSSI = heartbeat.avgRSSI;
+    if (fields & HB_FIELD_LOAD) known.networkLoad = heartbeat.networkLoad;
+    known.fields |= fields;
+    known.lastHeard = millis();
+}
+
+void RealMeshRouter::addRoute(const NodeAddress& destination, const NodeAddress& nextHop, uint8_t hopCount) {
+    addRoute(internAddress(destination), internAddress(nextHop), hopCount);
 }
 
 void RealMeshRouter::removeRoute(const NodeAddress& destination) {
-    String key = addressToKey(destination);
-    
-    if (routingTable.find(key) != routingTable.end()) {
-        Serial.printf("[ROUTER] Removed route to %s\n", destination.getFullAddress().c_str());
-        routingTable.erase(key);
-        
-        if (routeCallback) {
-            routeCallback("Route removed: " + destination.getFullAddress());
-        }
+    AddressHandle handle = addresses.lookup(destination);
+    if (handle != RM_INVALID_ADDRESS) {
+        removeRoute(handle);
     }
 }
 
 void RealMeshRouter::updateRouteQuality(const NodeAddress& destination, int16_t rssi, bool success) {
-    String key = addressToKey(destination);
+    AddressHandle handle = addresses.lookup(destination);
+    if (handle != RM_INVALID_ADDRESS) {
+        updateRouteQuality(handle, rssi, success);
+    }
+}
+
+RoutingEntry* RealMeshRouter::findRoute(const NodeAddress& destination) {
+    AddressHandle handle = addresses.lookup(destination);
+    return handle != RM_INVALID_ADDRESS ? findRoute(handle) : nullptr;
+}
+
+void RealMeshRouter::addRoute(AddressHandle destination, AddressHandle nextHop, uint8_t hopCount) {
+    RouteCandidate* candidate = addRouteCandidate(destination, nextHop);
+    if (!candidate) {
+        return;
+    }
     
-    if (routingTable.find(key) != routingTable.end()) {
-        RoutingEntry& entry = routingTable[key];
-        entry.lastUsed = millis();
-        entry.signalStrength = rssi;
-        
-        // Update reliability score
-        if (success) {
-            entry.reliability = min(100, entry.reliability + 5);
-        } else {
-            entry.reliability = max(0, entry.reliability - 20);
-        }
+    candidate->hopCount = hopCount;
+    rankRouteCandidates(*routingTable.find(destination));
+}
+
+void RealMeshRouter::removeRoute(AddressHandle destination) {
+    if (routingTable.remove(destination)) {
+        Serial.printf("[ROUTER] Removed route to %s\n", addresses.nameOf(destination).c_str());
+        stats.routingTableSize = routingTable.size();
         
-        // Remove route if reliability drops too low
-        if (entry.reliability < 20) {
-            Serial.printf("[ROUTER] Route to %s reliability too low, removing\n", 
-                         destination.getFullAddress().c_str());
-            removeRoute(destination);
+        if (routeCallback) {
+            routeCallback("Route removed: " + addresses.nameOf(destination));
         }
     }
 }
 
-RoutingEntry* RealMeshRouter::findRoute(const NodeAddress& destination) {
-    String key = addressToKey(destination);
+void RealMeshRouter::updateRouteQuality(AddressHandle destination, int16_t rssi, bool success) {
+    RoutingEntry* entry = routingTable.find(destination);
+    if (!entry || entry->candidateCount == 0) {
+        return;
+    }
+    
+    // Traffic always goes via the primary, so that's the one being judged
+    RouteCandidate& primary = entry->candidates[0];
+    entry->lastUsed = millis();
+    primary.lastUpdated = entry->lastUsed;
+    primary.signalStrength = rssi;
     
-    auto it = routingTable.find(key);
-    if (it != routingTable.end() && it->second.isValid && !isRouteExpired(it->second)) {
-        return &it->second;
+    if (success) {
+        primary.reliability = min(100, primary.reliability + 5);
+    } else {
+        primary.reliability = max(0, primary.reliability - 20);
+    }
+    
+    // A failing primary hands over to the next candidate; the route only
+    // goes away once no usable candidate is left
+    AddressHandle usedHop = primary.nextHop;
+    rankRouteCandidates(*entry);
+    if (entry->candidateCount == 0) {
+        Serial.printf("[ROUTER] Route to %s has no reliable next hop left, removing\n", 
+                     addresses.nameOf(destination).c_str());
+        removeRoute(destination);
+        resetHeartbeatTimer("route lost");
+    } else if (!success && entry->candidates[0].nextHop != usedHop) {
+        // Evictions and aging are routine; only a route in use failing
+        // means the topology moved
+        resetHeartbeatTimer("route failed over");
+    }
+}
+
+RoutingEntry* RealMeshRouter::findRoute(AddressHandle destination) {
+    RoutingEntry* entry = routingTable.find(destination);
+    if (entry && entry->isValid && !isRouteExpired(*entry)) {
+        return entry;
     }
     
     return nullptr;
 }
 
 void RealMeshRouter::recordBridge(const NodeAddress& nodeA, const NodeAddress& nodeB) {
+    recordBridge(internAddress(nodeA), internAddress(nodeB));
+}
+
+void RealMeshRouter::recordBridge(AddressHandle nodeA, AddressHandle nodeB) {
+    if (nodeA == RM_INVALID_ADDRESS || nodeB == RM_INVALID_ADDRESS) {
+        return;
+    }
+    
     // Check if we already have this bridge recorded
     for (auto& entry : intermediaryMemory) {
-        if ((entry.nodeA.getFullAddress() == nodeA.getFullAddress() && 
-             entry.nodeB.getFullAddress() == nodeB.getFullAddress()) ||
-            (entry.nodeA.getFullAddress() == nodeB.getFullAddress() && 
-             entry.nodeB.getFullAddress() == nodeA.getFullAddress())) {
+        if ((entry.nodeA == nodeA && entry.nodeB == nodeB) ||
+            (entry.nodeA == nodeB && entry.nodeB == nodeA)) {
             
             entry.lastBridged = millis();
             entry.bridgeCount++;
@@ -269,8 +572,8 @@ void RealMeshRouter::recordBridge(const NodeAddress& nodeA, const NodeAddress& n
     intermediaryMemory.push_back(newEntry);
     
     Serial.printf("[ROUTER] Recorded bridge: %s <-> %s\n",
-                 nodeA.getFullAddress().c_str(),
-                 nodeB.getFullAddress().c_str());
+                 addresses.nameOf(nodeA).c_str(),
+                 addresses.nameOf(nodeB).c_str());
 }
 
 bool RealMeshRouter::canBridge(const NodeAddress& nodeA, const NodeAddress& nodeB) {
@@ -285,11 +588,11 @@ void RealMeshRouter::setOwnStatus(NodeStatus status) {
         
         // Update subdomain hub status
         if (status == NODE_STATIONARY) {
-            addStationaryHub(ownAddress);
+            addStationaryHub(ownHandle);
         }
         
-        // Send immediate heartbeat to announce status change
-        sendHeartbeat();
+        // Announce the new status and switch to its maximum interval
+        resetHeartbeatTimer("status change");
     }
 }
 
@@ -302,37 +605,72 @@ void RealMeshRouter::setCallbacks(OnSendPacket sendCallback, OnMessageForUs mess
 // Private implementation methods
 
 bool RealMeshRouter::handleDataMessage(const MessagePacket& packet, int16_t rssi) {
-    Serial.printf("[ROUTER] Received data message from %s: %.*s\n",
-                 packet.source.getFullAddress().c_str(),
-                 packet.header.payloadLength,
-                 (char*)packet.payload);
-    
-    // Send ACK back to sender
-    MessagePacket ackPacket = RealMeshPacket::createAckPacket(ownAddress, packet.source, packet.header.messageId);
-    if (sendCallback) {
-        sendCallback(ackPacket);
+    // The application only ever sees plain text. A payload that won't
+    // decompress is neither delivered nor acknowledged.
+    PacketHandle plain;
+    const MessagePacket* message = &packet;
+    if (packet.header.routingFlags & ROUTE_COMPRESSED) {
+        plain = RealMeshPacketPool::acquire();
+        if (!plain) {
+            Serial.println("[ROUTER] Packet pool exhausted, data message left unacknowledged");
+            return false;
+        }
+        
+        size_t length = RealMeshCompression::decompress(packet.payload, packet.header.payloadLength,
+                                                        plain->payload, RM_MAX_PAYLOAD_SIZE);
+        if (length == 0) {
+            Serial.printf("[ROUTER] Data message from %s failed to decompress\n",
+                         packet.source.getFullAddress().c_str());
+            return false;
+        }
+        plain->header = packet.header;
+        plain->header.payloadLength = length;
+        plain->header.routingFlags &= ~ROUTE_COMPRESSED;
+        plain->source = packet.source;
+        plain->destination = packet.destination;
+        message = &*plain;
     }
     
+    Serial.printf("[ROUTER] Received data message from %s: %.*s\n",
+                 message->source.getFullAddress().c_str(),
+                 message->header.payloadLength,
+                 (char*)message->payload);
+    
     // Deliver message to application
     if (messageCallback) {
-        messageCallback(packet);
+        messageCallback(*message);
+    }
+    
+    // Acknowledge direct messages only - every receiver ACKing a broadcast would storm the channel
+    if (packet.destination.sameAddress(ownAddress)) {
+        sendAck(packet, packet.header.messageId);
     }
     
     return false; // Don't forward - message was for us
 }
 
-bool RealMeshRouter::routePacketDirect(MessagePacket& packet) {
-    RoutingEntry* route = findRoute(packet.destination);
+bool RealMeshRouter::payloadDecodes(const MessagePacket& packet) {
+    if (!(packet.header.routingFlags & ROUTE_COMPRESSED)) {
+        return true;
+    }
     
-    if (route) {
+    uint8_t text[RM_MAX_PAYLOAD_SIZE];
+    return RealMeshCompression::decompress(packet.payload, packet.header.payloadLength, text, sizeof(text)) > 0;
+}
+
+bool RealMeshRouter::routePacketDirect(PacketHandle& packet) {
+    RoutingEntry* route = findRoute(packet->destination);
+    
+    if (route && packet.detach()) {
         Serial.printf("[ROUTER] Using direct route to %s via %s\n",
-                     packet.destination.getFullAddress().c_str(),
-                     route->nextHop.getFullAddress().c_str());
+                     packet->destination.getFullAddress().c_str(),
+                     addresses.nameOf(route->nextHop).c_str());
         
-        packet.header.routingFlags = ROUTE_DIRECT;
-        addToPathHistory(packet);
+        packet->header.routingFlags = ROUTE_DIRECT | (packet->header.routingFlags & RM_PAYLOAD_FLAGS);
+        packet->header.nextHop = addresses.shortIdOf(route->nextHop);
+        addToPathHistory(*packet);
         
-        if (sendCallback && sendCallback(packet)) {
+        if (enqueuePacket(packet)) {
             stats.messagesSent++;
             route->lastUsed = millis();
             return true;
@@ -342,51 +680,56 @@ bool RealMeshRouter::routePacketDirect(MessagePacket& packet) {
     return false;
 }
 
-bool RealMeshRouter::routePacketSubdomain(MessagePacket& packet) {
+bool RealMeshRouter::routePacketSubdomain(PacketHandle& packet) {
     // Only try subdomain routing if destination has different subdomain
-    if (packet.destination.subdomain == ownAddress.subdomain) {
+    if (packet->destination.subdomain == ownAddress.subdomain) {
         return false;
     }
     
     // Find stationary hubs in target subdomain
-    std::vector<NodeAddress> helpers = findSubdomainHelpers(packet.destination.subdomain);
+    std::vector<AddressHandle> helpers = findSubdomainHelpers(packet->destination.subdomain);
     
-    for (const NodeAddress& helper : helpers) {
+    for (AddressHandle helper : helpers) {
         RoutingEntry* route = findRoute(helper);
-        if (route) {
+        if (route && packet.detach()) {
             Serial.printf("[ROUTER] Using subdomain route to %s via hub %s\n",
-                         packet.destination.getFullAddress().c_str(),
-                         helper.getFullAddress().c_str());
+                         packet->destination.getFullAddress().c_str(),
+                         addresses.nameOf(helper).c_str());
             
-            packet.header.routingFlags = ROUTE_SUBDOMAIN_RETRY;
-            addToPathHistory(packet);
+            packet->header.routingFlags = ROUTE_SUBDOMAIN_RETRY | (packet->header.routingFlags & RM_PAYLOAD_FLAGS);
+            addToPathHistory(*packet);
             
-            // Temporarily change destination to the helper
-            NodeAddress originalDest = packet.destination;
-            packet.destination = helper;
+            // The queued copy goes to the hub; ours keeps the real destination
+            PacketHandle viaHub = packet;
+            if (!viaHub.detach()) {
+                return false;
+            }
+            viaHub->destination = addresses.get(helper);
             
-            if (sendCallback && sendCallback(packet)) {
-                // Restore original destination
-                packet.destination = originalDest;
+            if (enqueuePacket(viaHub)) {
                 stats.messagesSent++;
                 return true;
             }
-            
-            packet.destination = originalDest;
         }
     }
     
     return false;
 }
 
-bool RealMeshRouter::routePacketFlood(MessagePacket& packet) {
-    Serial.printf("[ROUTER] Using flood routing for %s\n", packet.destination.getFullAddress().c_str());
+bool RealMeshRouter::routePacketFlood(PacketHandle& packet) {
+    if (!packet.detach()) {
+        return false;
+    }
     
-    packet.header.routingFlags = ROUTE_FLOOD;
-    packet.header.hopCount = 0;
-    addToPathHistory(packet);
+    Serial.printf("[ROUTER] Using flood routing for %s\n", packet->destination.getFullAddress().c_str());
     
-    if (sendCallback && sendCallback(packet)) {
+    packet->header.routingFlags = ROUTE_FLOOD |
+                                  (packet->header.routingFlags & (RM_PAYLOAD_FLAGS | ROUTE_RETRY_MASK));
+    packet->header.hopCount = 0;
+    packet->header.nextHop = 0; // Every neighbor may relay a flood
+    addToPathHistory(*packet);
+    
+    if (enqueuePacket(packet)) {
         stats.messagesSent++;
         return true;
     }
@@ -394,180 +737,1368 @@ bool RealMeshRouter::routePacketFlood(MessagePacket& packet) {
     return false;
 }
 
-bool RealMeshRouter::shouldForwardPacket(const MessagePacket& packet) {
+bool RealMeshRouter::shouldForwardPacket(PacketHandle handle, float snr) {
+    const MessagePacket& packet = *handle;
+    
     // Don't forward if we've seen this packet before (loop prevention)
     if (isInPathHistory(packet, ownAddress)) {
         return false;
     }
     
+    // Answer route requests from our own table instead of re-flooding them
+    if (packet.header.messageType == MSG_ROUTE_REQUEST && answerRouteRequest(packet)) {
+        return false;
+    }
+    
     // Don't forward if hop count exceeded
     if (packet.header.hopCount >= packet.header.maxHops) {
         return false;
     }
     
+    // The received packet itself is relayed; it is copied only when a
+    // local handler still needs it as received
+    if (!handle.detach()) {
+        Serial.println("[ROUTER] Packet pool exhausted, relay dropped");
+        stats.messagesDropped++;
+        return false;
+    }
+    MessagePacket& forwardPacket = *handle;
+    
     // If we're a stationary hub and this is for our subdomain, help forward it
     if (ownStatus == NODE_STATIONARY && 
-        packet.destination.subdomain == ownAddress.subdomain &&
-        (packet.header.routingFlags & ROUTE_SUBDOMAIN_RETRY)) {
+        forwardPacket.destination.subdomain == ownAddress.subdomain &&
+        (forwardPacket.header.routingFlags & ROUTE_SUBDOMAIN_RETRY)) {
         
-        Serial.printf("[ROUTER] Acting as subdomain hub for %s\n", packet.destination.getFullAddress().c_str());
+        Serial.printf("[ROUTER] Acting as subdomain hub for %s\n", forwardPacket.destination.getFullAddress().c_str());
         
         // Try to forward to the actual destination
-        RoutingEntry* route = findRoute(packet.destination);
+        RoutingEntry* route = findRoute(forwardPacket.destination);
         if (route) {
-            MessagePacket forwardPacket = packet;
+            MessageHeader received = forwardPacket.header;
             forwardPacket.header.hopCount++;
             addToPathHistory(forwardPacket);
             
-            if (sendCallback && sendCallback(forwardPacket)) {
+            if (enqueuePacket(handle)) {
                 stats.messagesForwarded++;
                 
                 // Record this as a successful bridge
-                recordBridge(packet.source, packet.destination);
+                recordBridge(forwardPacket.source, forwardPacket.destination);
+                return true;
+            }
+            forwardPacket.header = received;
+        }
+    }
+    
+    // Relay direct packets only when the sender picked us as its next hop
+    if ((forwardPacket.header.routingFlags & ROUTE_DIRECT) && forwardPacket.destination.isValid()) {
+        if (forwardPacket.header.nextHop != 0 && forwardPacket.header.nextHop != ownAddress.uuid.getShortId()) {
+            return false;
+        }
+        
+        RoutingEntry* route = findRoute(forwardPacket.destination);
+        if (route) {
+            MessageHeader received = forwardPacket.header;
+            forwardPacket.header.hopCount++;
+            forwardPacket.header.nextHop = addresses.shortIdOf(route->nextHop);
+            addToPathHistory(forwardPacket);
+            
+            if (enqueuePacket(handle)) {
+                stats.messagesForwarded++;
                 return true;
             }
+            forwardPacket.header = received;
         }
     }
     
-    // Forward flood messages (with hop limit)
-    if (packet.header.routingFlags & ROUTE_FLOOD) {
-        MessagePacket forwardPacket = packet;
+    // Forward flood messages (with hop limit) after a contention delay
+    if (forwardPacket.header.routingFlags & ROUTE_FLOOD) {
         forwardPacket.header.hopCount++;
         addToPathHistory(forwardPacket);
         
-        if (sendCallback && sendCallback(forwardPacket)) {
-            stats.messagesForwarded++;
-            return true;
-        }
+        return scheduleRebroadcast(handle, snr);
     }
     
     return false;
 }
 
-void RealMeshRouter::updatePathFromPacket(const MessagePacket& packet, int16_t rssi) {
+void RealMeshRouter::updatePathFromPacket(const MessagePacket& packet, AddressHandle source, int16_t rssi) {
+    uint8_t hops = packet.header.hopCount;
+    
     // If packet came directly to us, we have a direct route to sender
-    if (packet.header.hopCount == 0) {
-        addRoute(packet.source, packet.source, 1);
-        updateRouteQuality(packet.source, rssi, true);
-    } else {
-        // Learn multi-hop route (source is reachable via previous hop)
-        if (packet.header.pathHistory[0] != 0) {
-            // TODO: Decode previous hop from path history and add route
-        }
+    if (hops == 0) {
+        learnRoute(source, source, 1, rssi);
+        return;
     }
-}
-
-std::vector<NodeAddress> RealMeshRouter::findSubdomainHelpers(const String& targetSubdomain) {
-    std::vector<NodeAddress> helpers;
     
-    if (subdomains.find(targetSubdomain) != subdomains.end()) {
-        const SubdomainInfo& info = subdomains[targetSubdomain];
-        for (const NodeAddress& hub : info.stationaryHubs) {
-            if (findRoute(hub) != nullptr) {
-                helpers.push_back(hub);
-            }
-        }
+    // pathHistory[0] is whoever transmitted this copy - the last relay.
+    // Without a UUID for it we can't name the next hop yet.
+    AddressHandle relay = addresses.findByShortId(packet.header.pathHistory[0]);
+    if (relay == RM_INVALID_ADDRESS || relay == ownHandle || relay == source) {
+        return;
     }
     
-    return helpers;
+    // We heard the relay directly, and the source sits behind it
+    learnRoute(relay, relay, 1, rssi);
+    learnRoute(source, relay, hops + 1, rssi);
+    
+    // Older relays in the history are reachable through the same neighbor
+    for (uint8_t i = 1; i < RM_PATH_HISTORY_SIZE && i < hops; i++) {
+        AddressHandle hop = addresses.findByShortId(packet.header.pathHistory[i]);
+        if (hop != RM_INVALID_ADDRESS && hop != ownHandle && hop != source && hop != relay) {
+            learnRoute(hop, relay, i + 1, rssi);
+        }
+    }
 }
 
-void RealMeshRouter::addStationaryHub(const NodeAddress& hub) {
-    SubdomainInfo& info = subdomains[hub.subdomain];
+void RealMeshRouter::learnRoute(AddressHandle destination, AddressHandle nextHop, uint8_t hopCount, int16_t rssi) {
+    RoutingEntry* entry = routingTable.find(destination);
+    bool known = entry && findRouteCandidate(*entry, nextHop) != nullptr;
     
-    // Check if already in the list
-    for (const NodeAddress& existing : info.stationaryHubs) {
-        if (existing.getFullAddress() == hub.getFullAddress()) {
-            return;
-        }
+    RouteCandidate* candidate = addRouteCandidate(destination, nextHop);
+    if (!candidate) {
+        return;
     }
     
-    info.stationaryHubs.push_back(hub);
-    Serial.printf("[ROUTER] Added stationary hub: %s for subdomain %s\n",
-                 hub.getFullAddress().c_str(),
-                 hub.subdomain.c_str());
+    // Hearing the same path again counts in its favour
+    if (known) {
+        candidate->reliability = min(100, candidate->reliability + 5);
+    }
+    candidate->hopCount = hopCount;
+    candidate->signalStrength = rssi;
+    
+    entry = routingTable.find(destination);
+    entry->lastUsed = millis();
+    rankRouteCandidates(*entry);
 }
 
-String RealMeshRouter::addressToKey(const NodeAddress& address) {
-    return address.getFullAddress();
-}
+// Route selection
 
-bool RealMeshRouter::isValidPacket(const MessagePacket& packet) {
-    return packet.source.isValid() && 
-           packet.header.protocolVersion == RM_PROTOCOL_VERSION &&
-           packet.header.payloadLength <= RM_MAX_PAYLOAD_SIZE;
+RouteCandidate* RealMeshRouter::findRouteCandidate(RoutingEntry& entry, AddressHandle nextHop) {
+    for (uint8_t i = 0; i < entry.candidateCount; i++) {
+        if (entry.candidates[i].nextHop == nextHop) {
+            return &entry.candidates[i];
+        }
+    }
+    return nullptr;
 }
 
-bool RealMeshRouter::isPacketForUs(const MessagePacket& packet) {
-    // Check if destination matches our address
-    if (packet.destination.getFullAddress() == ownAddress.getFullAddress()) {
-        return true;
+RouteCandidate* RealMeshRouter::addRouteCandidate(AddressHandle destination, AddressHandle nextHop) {
+    if (destination == RM_INVALID_ADDRESS || nextHop == RM_INVALID_ADDRESS) {
+        return nullptr;
     }
     
-    // Check if it's a broadcast (empty destination)
-    if (packet.destination.nodeId.isEmpty() && packet.destination.subdomain.isEmpty()) {
-        return true;
+    RoutingEntry* entry = routingTable.insert(destination);
+    
+    if (!entry) {
+        // Table is full - evict the least recently used route to make room
+        size_t oldest = 0;
+        for (size_t i = 1; i < routingTable.size(); i++) {
+            if (routingTable.at(i).lastUsed < routingTable.at(oldest).lastUsed) {
+                oldest = i;
+            }
+        }
+        removeRoute(routingTable.at(oldest).destination);
+        entry = routingTable.insert(destination);
+        if (!entry) {
+            return nullptr;
+        }
     }
     
-    // Check if it's a subdomain broadcast for our subdomain
-    if (packet.destination.nodeId.isEmpty() && packet.destination.subdomain == ownAddress.subdomain) {
-        return true;
+    RouteCandidate* candidate = findRouteCandidate(*entry, nextHop);
+    if (candidate) {
+        candidate->lastUpdated = millis();
+        return candidate;
     }
     
-    return false;
-}
-
-void RealMeshRouter::addToPathHistory(MessagePacket& packet) {
-    // Shift path history and add ourselves
-    for (int i = RM_PATH_HISTORY_SIZE - 1; i > 0; i--) {
-        packet.header.pathHistory[i] = packet.header.pathHistory[i-1];
+    bool newRoute = entry->candidateCount == 0;
+    
+    // Candidates are kept ranked, so a full set gives up its weakest
+    // member unless that one is statically preferred
+    if (entry->candidateCount >= RM_ROUTE_CANDIDATES) {
+        if (entry->candidates[RM_ROUTE_CANDIDATES - 1].preference > 0) {
+            return nullptr;
+        }
+        entry->candidateCount--;
+    }
+    
+    candidate = &entry->candidates[entry->candidateCount++];
+    *candidate = RouteCandidate();
+    candidate->nextHop = nextHop;
+    candidate->hopCount = 1;
+    candidate->reliability = 100; // Start optimistic
+    candidate->lastUpdated = millis();
+    
+    entry->lastUsed = millis();
+    entry->isValid = true;
+    stats.routingTableSize = routingTable.size();
+    
+    if (newRoute) {
+        entry->nextHop = RM_INVALID_ADDRESS;
+        Serial.printf("[ROUTER] Added route: %s -> %s\n",
+                     addresses.nameOf(destination).c_str(),
+                     addresses.nameOf(nextHop).c_str());
+        
+        if (routeCallback) {
+            routeCallback("Route added: " + addresses.nameOf(destination));
+        }
+    } else {
+        Serial.printf("[ROUTER] Added alternative next hop to %s: %s\n",
+                     addresses.nameOf(destination).c_str(),
+                     addresses.nameOf(nextHop).c_str());
     }
     
-    // Add our node ID (simplified to first byte of UUID)
-    packet.header.pathHistory[0] = ownAddress.uuid.bytes[0];
+    return candidate;
 }
 
-bool RealMeshRouter::isInPathHistory(const MessagePacket& packet, const NodeAddress& address) {
-    uint8_t nodeId = address.uuid.bytes[0];
+void RealMeshRouter::rankRouteCandidates(RoutingEntry& entry) {
+    uint32_t now = millis();
+    
+    // Forget next hops that keep failing (static preferences stay)
+    uint8_t kept = 0;
+    for (uint8_t i = 0; i < entry.candidateCount; i++) {
+        const RouteCandidate& candidate = entry.candidates[i];
+        if (candidate.reliability >= RM_ROUTE_MIN_RELIABILITY || candidate.preference > 0) {
+            entry.candidates[kept++] = candidate;
+        }
+    }
+    entry.candidateCount = kept;
     
-    for (int i = 0; i < RM_PATH_HISTORY_SIZE; i++) {
-        if (packet.header.pathHistory[i] == nodeId) {
-            return true;
+    if (entry.candidateCount == 0) {
+        entry.nextHop = RM_INVALID_ADDRESS;
+        entry.backupHop = RM_INVALID_ADDRESS;
+        return;
+    }
+    
+    // Healthy before failing, fresh before stale, then by cost
+    float score[RM_ROUTE_CANDIDATES];
+    for (uint8_t i = 0; i < entry.candidateCount; i++) {
+        const RouteCandidate& candidate = entry.candidates[i];
+        score[i] = routeCost(candidate);
+        if (now - candidate.lastUpdated > RM_ROUTE_STALE_MS) score[i] += 1000.0f;
+        if (candidate.reliability < RM_ROUTE_FAILOVER_RELIABILITY) score[i] += 2000.0f;
+    }
+    
+    for (uint8_t i = 1; i < entry.candidateCount; i++) {
+        RouteCandidate candidate = entry.candidates[i];
+        float key = score[i];
+        int j = i - 1;
+        while (j >= 0 && score[j] > key) {
+            entry.candidates[j + 1] = entry.candidates[j];
+            score[j + 1] = score[j];
+            j--;
         }
+        entry.candidates[j + 1] = candidate;
+        score[j + 1] = key;
     }
     
-    return false;
+    // Keep a healthy primary unless the best alternative is clearly better,
+    // so near-equal paths don't flap
+    AddressHandle previous = entry.nextHop;
+    for (uint8_t i = 1; i < entry.candidateCount; i++) {
+        if (entry.candidates[i].nextHop == previous && score[i] <= score[0] + RM_ROUTE_SWITCH_MARGIN) {
+            RouteCandidate candidate = entry.candidates[i];
+            memmove(&entry.candidates[1], &entry.candidates[0], i * sizeof(RouteCandidate));
+            entry.candidates[0] = candidate;
+            break;
+        }
+    }
+    
+    const RouteCandidate& primary = entry.candidates[0];
+    if (previous != RM_INVALID_ADDRESS && previous != primary.nextHop) {
+        Serial.printf("[ROUTER] Route to %s switched from %s to %s\n",
+                     addresses.nameOf(entry.destination).c_str(),
+                     addresses.nameOf(previous).c_str(),
+                     addresses.nameOf(primary.nextHop).c_str());
+    }
+    
+    // Mirror the primary into the entry fields the rest of the router reads
+    entry.nextHop = primary.nextHop;
+    entry.hopCount = primary.hopCount;
+    entry.signalStrength = primary.signalStrength;
+    entry.reliability = primary.reliability;
+    entry.backupHop = entry.candidateCount > 1 ? entry.candidates[1].nextHop : RM_INVALID_ADDRESS;
 }
 
-bool RealMeshRouter::isRouteExpired(const RoutingEntry& entry) {
-    // Routes expire after 1 hour of non-use for mobile nodes
-    // Stationary routes expire after 24 hours
-    uint32_t expireTime = (ownStatus == NODE_STATIONARY) ? 86400000 : 3600000;
-    return (millis() - entry.lastUsed) > expireTime;
+float RealMeshRouter::routeCost(const RouteCandidate& candidate) const {
+    if (costFunction) {
+        return costFunction(candidate);
+    }
+    
+    // We can measure the first hop; assume the rest cost one transmission each
+    float etx = linkEtx(candidate.nextHop) + (candidate.hopCount > 1 ? candidate.hopCount - 1 : 0);
+    
+    return metricPolicy.hopWeight * candidate.hopCount +
+           metricPolicy.etxWeight * etx +
+           metricPolicy.latencyWeight * candidate.latencyMs / 1000.0f -
+           metricPolicy.preferenceWeight * candidate.preference;
 }
 
-void RealMeshRouter::printRoutingTable() {
-    Serial.printf("[ROUTER] Routing Table (%d entries):\n", routingTable.size());
-    for (const auto& pair : routingTable) {
-        const RoutingEntry& entry = pair.second;
-        Serial.printf("  %s -> %s (hops: %d, rel: %d%%, rssi: %ddBm)\n",
-                     entry.destination.getFullAddress().c_str(),
-                     entry.nextHop.getFullAddress().c_str(),
-                     entry.hopCount,
-                     entry.reliability,
-                     entry.signalStrength);
+void RealMeshRouter::recordRouteLatency(AddressHandle destination, uint32_t latencyMs) {
+    RoutingEntry* entry = routingTable.find(destination);
+    if (!entry || entry->candidateCount == 0) {
+        return;
     }
+    
+    RouteCandidate& primary = entry->candidates[0];
+    uint16_t sample = (uint16_t)min(latencyMs, (uint32_t)UINT16_MAX);
+    primary.latencyMs = primary.latencyMs == 0 ? sample : (primary.latencyMs * 3 + sample) / 4;
 }
 
-void RealMeshRouter::printSubdomainInfo() {
-    Serial.printf("[ROUTER] Subdomain Information (%d subdomains):\n", subdomains.size());
-    for (const auto& pair : subdomains) {
-        const SubdomainInfo& info = pair.second;
-        Serial.printf("  %s: %d nodes, %d hubs, %s\n",
-                     info.subdomainName.c_str(),
-                     info.knownNodes.size(),
-                     info.stationaryHubs.size(),
-                     info.isLocal ? "LOCAL" : "REMOTE");
+// Transmit queueing
+
+bool RealMeshRouter::enqueuePacket(const MessagePacket& packet) {
+    // Built on the stack by a factory or routing step; the queue keeps a
+    // pool copy, so the caller may go on changing its own
+    PacketHandle handle = RealMeshPacketPool::acquire(packet);
+    if (!handle) {
+        Serial.printf("[ROUTER] Packet pool exhausted, message %u not queued\n", packet.header.messageId);
+        stats.messagesDropped++;
+        return false;
+    }
+    
+    return enqueuePacket(handle);
+}
+
+bool RealMeshRouter::enqueuePacket(const PacketHandle& handle) {
+    const MessagePacket& packet = *handle;
+    
+    // Remember what we originate so copies relayed back are dropped as
+    // duplicates (retries reuse the messageId; a flooded one has a new count)
+    uint16_t ownId = ownAddress.uuid.getShortId();
+    uint8_t retry = RM_ROUTE_RETRY(packet.header.routingFlags);
+    if (packet.source.uuid == ownAddress.uuid && !isDuplicatePacket(ownId, packet.header.messageId, retry)) {
+        rememberPacket(ownId, packet.header.messageId, retry);
+    }
+    
+    // Count evictions made to fit this packet as well as the packet itself
+    uint32_t droppedBefore = txQueue.getDropped();
+    bool queued = txQueue.enqueue(handle, stats.networkLoad);
+    stats.messagesDropped += txQueue.getDropped() - droppedBefore;
+    
+    if (!queued) {
+        return false;
+    }
+    
+    // Send right away when the radio is free; otherwise loop() retries
+    processTransmitQueue();
+    return true;
+}
+
+void RealMeshRouter::processTransmitQueue() {
+    stats.messagesDropped += txQueue.expire(stats.networkLoad);
+    
+    // Next hops whose small frames are waiting for companions; everything
+    // else keeps draining past them
+    std::vector<uint16_t> holding;
+    auto held = [&](const QueueEntry& entry) {
+        return isAggregatable(*entry.packet) &&
+               std::find(holding.begin(), holding.end(),
+                         entry.packet->header.nextHop) != holding.end();
+    };
+    
+    QueueEntry* entry;
+    while (sendCallback && (entry = txQueue.peek(stats.networkLoad, held)) != nullptr) {
+        // Radio busy or airtime budget spent - leave it queued, the
+        // queue's age limits shed low priority traffic if this lasts
+        if (canSendCallback && !canSendCallback(*entry->packet)) {
+            break;
+        }
+        
+        // Small frames share one preamble with others for the same next hop
+        if (isAggregatable(*entry->packet)) {
+            if (!transmitAggregate(entry)) {
+                holding.push_back(entry->packet->header.nextHop);
+            }
+            continue;
+        }
+        
+        if (!sendCallback(*entry->packet)) {
+            stats.messagesDropped++;
+        }
+        txQueue.pop(entry);
+    }
+}
+
+bool RealMeshRouter::isAggregatable(const MessagePacket& packet) const {
+    return RM_AGGREGATE_ENABLED && packet.header.priority != PRIORITY_EMERGENCY &&
+           RealMeshPacket::serializedSize(packet) <= RM_AGGREGATE_MAX_FRAME;
+}
+
+bool RealMeshRouter::transmitAggregate(QueueEntry* head) {
+    // Pack whatever else is waiting for the same next hop (0 = broadcast),
+    // in drain order, while it fits. The container is built in a pool slot.
+    PacketHandle aggregate = RealMeshPacketPool::acquire();
+    std::vector<const QueueEntry*> members;
+    members.push_back(head);
+    
+    if (aggregate) {
+        RealMeshPacket::initAggregate(*aggregate, *head->packet);
+        txQueue.forEach([&](const QueueEntry& entry) {
+            if (&entry != head && isAggregatable(*entry.packet) &&
+                entry.packet->header.nextHop == head->packet->header.nextHop &&
+                RealMeshPacket::appendToAggregate(*aggregate, *entry.packet)) {
+                members.push_back(&entry);
+            }
+        });
+        
+        // Once companions are waiting, give late ones a moment on an idle
+        // radio unless nothing more would fit. A frame with nothing to join
+        // goes right away, as do frames that already waited for the channel.
+        bool full = aggregate->wireLength + 1 + RM_AGGREGATE_MAX_FRAME > RM_MAX_PACKET_SIZE;
+        if (members.size() > 1 && !full &&
+            millis() - head->queuedTime < RM_AGGREGATE_HOLD_MS) {
+            return false;
+        }
+    }
+    
+    // Alone after all, no slot for the container, or the bigger frame is
+    // over the airtime budget
+    if (members.size() == 1 || (canSendCallback && !canSendCallback(*aggregate))) {
+        if (!sendCallback(*head->packet)) {
+            stats.messagesDropped++;
+        }
+        txQueue.pop(head);
+        return true;
+    }
+    
+    if (sendCallback(*aggregate)) {
+        stats.framesAggregated += members.size() - 1;
+    } else {
+        stats.messagesDropped += members.size();
+    }
+    txQueue.remove(members);
+    return true;
+}
+
+// Fragmentation
+
+bool RealMeshRouter::fragmentMessage(const NodeAddress& destination, const String& message, MessagePriority priority) {
+    if (message.length() > RM_FRAGMENT_MAX_MESSAGE) {
+        Serial.printf("[ROUTER] Message of %d bytes exceeds the %d byte limit\n",
+                     message.length(), RM_FRAGMENT_MAX_MESSAGE);
+        return false;
+    }
+    
+    if (outgoingFragments.size() >= RM_MAX_FRAGMENTED_MESSAGES) {
+        Serial.println("[ROUTER] Too many fragmented messages in flight");
+        return false;
+    }
+    
+    // Compress the whole message once; every fragment carries a slice of it
+    const uint8_t* text = reinterpret_cast<const uint8_t*>(message.c_str());
+    std::vector<uint8_t> data(message.length());
+    size_t compressedLen = RM_COMPRESSION_ENABLED ?
+        RealMeshCompression::compress(text, message.length(), data.data(), data.size()) : 0;
+    if (compressedLen > 0) {
+        data.resize(compressedLen);
+    } else {
+        data.assign(text, text + message.length());
+    }
+    
+    uint16_t chunkSize = fragmentChunkSize(destination, data.size());
+    uint8_t count = (data.size() + chunkSize - 1) / chunkSize;
+    
+    // The last fragment is built first: its messageId names the whole
+    // message, and it is what the ACK timer retries
+    FragmentData last;
+    last.messageId = 0;
+    last.index = count - 1;
+    last.count = count;
+    last.offset = (count - 1) * chunkSize;
+    last.data = data.data() + last.offset;
+    last.length = data.size() - last.offset;
+    PacketHandle lastFragment = RealMeshPacketPool::acquire(
+        RealMeshPacket::createFragmentPacket(ownAddress, destination, last, priority, compressedLen > 0));
+    if (!lastFragment) {
+        Serial.println("[ROUTER] Packet pool exhausted, message not sent");
+        stats.messagesDropped++;
+        return false;
+    }
+    
+    uint32_t messageId = lastFragment->header.messageId;
+    FragmentedMessage& outgoing = outgoingFragments[messageId];
+    outgoing.destination = destination;
+    outgoing.data.swap(data);
+    outgoing.compressed = compressedLen > 0;
+    outgoing.priority = priority;
+    outgoing.chunkSize = chunkSize;
+    outgoing.count = count;
+    outgoing.pending = fragmentMask(count);
+    outgoing.lastFragment = std::move(lastFragment);
+    outgoing.created = millis();
+    
+    lastMessageId = messageId;
+    
+    Serial.printf("[ROUTER] Routing %d byte message to %s in %d fragments of %d bytes%s\n",
+                 message.length(), destination.getFullAddress().c_str(), count, chunkSize,
+                 outgoing.compressed ? " (compressed)" : "");
+    
+    processFragments();
+    return true;
+}
+
+uint16_t RealMeshRouter::fragmentChunkSize(const NodeAddress& destination, size_t messageLength) {
+    size_t overhead = frameOverhead(MSG_FRAGMENT, destination) + RealMeshPacket::FRAGMENT_HEADER_SIZE;
+    size_t maxChunk = std::min((size_t)RM_MAX_PACKET_SIZE - overhead,
+                               (size_t)RM_MAX_PAYLOAD_SIZE - RealMeshPacket::FRAGMENT_HEADER_SIZE);
+    
+    // Largest fragment that stays within the airtime budget on the profile
+    // the next hop uses; slow links get short fragments so a loss costs less
+    size_t chunk = maxChunk;
+    while (chunk > RM_FRAGMENT_MIN_SIZE && frameAirtime(destination, overhead + chunk) > RM_FRAGMENT_MAX_AIRTIME_MS) {
+        chunk = std::max((size_t)RM_FRAGMENT_MIN_SIZE, chunk - 8);
+    }
+    
+    // The NACK bitmap caps the fragment count; long messages get bigger fragments
+    size_t needed = (messageLength + RM_FRAGMENT_MAX_COUNT - 1) / RM_FRAGMENT_MAX_COUNT;
+    return (uint16_t)std::min(maxChunk, std::max(chunk, needed));
+}
+
+size_t RealMeshRouter::frameOverhead(MessageType type, const NodeAddress& destination) const {
+    return RealMeshPacket::overheadSize(RM_PROTOCOL_VERSION, type, ownAddress, destination);
+}
+
+uint32_t RealMeshRouter::frameAirtime(const NodeAddress& destination, size_t bytes) {
+    RoutingEntry* route = destination.isValid() ? findRoute(destination) : nullptr;
+    uint16_t nextHop = route ? addresses.shortIdOf(route->nextHop) : 0;
+    
+    return airtimeCallback ? airtimeCallback(nextHop, bytes) : RealMeshAirtime::timeOnAirMs(bytes);
+}
+
+void RealMeshRouter::processFragments() {
+    cleanupReassembly();
+    
+    uint32_t now = millis();
+    auto it = outgoingFragments.begin();
+    while (it != outgoingFragments.end()) {
+        FragmentedMessage& outgoing = it->second;
+        
+        // Sent untracked (delivery table full) and never ACKed
+        if (now - outgoing.created > RM_MESSAGE_MAX_AGE) {
+            it = outgoingFragments.erase(it);
+            continue;
+        }
+        
+        // A few fragments at a time, so the message doesn't fill the queue
+        // and evict other traffic of its priority
+        AddressHandle destination = addresses.lookup(outgoing.destination);
+        while (outgoing.pending && txQueue.size(outgoing.priority) < RM_FRAGMENT_QUEUE_DEPTH &&
+               !pendingDiscoveries.count(destination)) {
+            uint8_t index = __builtin_ctz(outgoing.pending);
+            outgoing.pending &= ~(1UL << index);
+            
+            if (index == outgoing.count - 1) {
+                PacketHandle packet = outgoing.lastFragment;
+                dispatchPacket(packet);
+                if (outgoing.destination.isValid()) {
+                    trackDelivery(outgoing.lastFragment, packet->header.routingFlags);
+                }
+                continue;
+            }
+            
+            FragmentData fragment;
+            fragment.messageId = it->first;
+            fragment.index = index;
+            fragment.count = outgoing.count;
+            fragment.offset = index * outgoing.chunkSize;
+            fragment.data = outgoing.data.data() + fragment.offset;
+            fragment.length = outgoing.chunkSize;
+            
+            PacketHandle packet = RealMeshPacketPool::acquire(
+                RealMeshPacket::createFragmentPacket(ownAddress, outgoing.destination, fragment,
+                                                     outgoing.priority, outgoing.compressed));
+            if (!packet) {
+                outgoing.pending |= 1UL << index; // Sent once a slot frees up
+                break;
+            }
+            dispatchPacket(packet);
+        }
+        
+        // Broadcasts go out once; unicast waits for the ACK or a NACK
+        if (!outgoing.pending && !outgoing.destination.isValid()) {
+            it = outgoingFragments.erase(it);
+            continue;
+        }
+        ++it;
+    }
+}
+
+bool RealMeshRouter::reserveReassembly(ReassemblyBuffer& buffer, size_t bytes) {
+    size_t used = 0;
+    for (const auto& pair : reassemblyBuffers) {
+        used += pair.second.data.capacity();
+    }
+    
+    // Make room by dropping the messages that have waited longest
+    size_t growth = bytes > buffer.data.capacity() ? bytes - buffer.data.capacity() : 0;
+    while (used + growth > RM_REASSEMBLY_MEMORY) {
+        auto oldest = reassemblyBuffers.end();
+        for (auto it = reassemblyBuffers.begin(); it != reassemblyBuffers.end(); ++it) {
+            if (&it->second != &buffer && it->second.data.capacity() > 0 &&
+                (oldest == reassemblyBuffers.end() || it->second.lastUpdate < oldest->second.lastUpdate)) {
+                oldest = it;
+            }
+        }
+        
+        if (oldest == reassemblyBuffers.end()) {
+            return false;
+        }
+        
+        Serial.printf("[ROUTER] Reassembly of message %u from %s dropped for memory\n",
+                     oldest->second.messageId, addresses.nameOf(oldest->second.source).c_str());
+        used -= oldest->second.data.capacity();
+        reassemblyBuffers.erase(oldest);
+    }
+    
+    buffer.data.reserve(bytes);
+    return true;
+}
+
+void RealMeshRouter::cleanupReassembly() {
+    uint32_t now = millis();
+    
+    auto it = reassemblyBuffers.begin();
+    while (it != reassemblyBuffers.end()) {
+        const ReassemblyBuffer& buffer = it->second;
+        if (now - buffer.lastUpdate <= RM_REASSEMBLY_TIMEOUT_MS) {
+            ++it;
+            continue;
+        }
+        
+        if (!buffer.complete) {
+            Serial.printf("[ROUTER] Reassembly of message %u from %s timed out (%d of %d fragments)\n",
+                         buffer.messageId, addresses.nameOf(buffer.source).c_str(),
+                         __builtin_popcount(buffer.received), buffer.count);
+        }
+        it = reassemblyBuffers.erase(it);
+    }
+}
+
+uint32_t RealMeshRouter::fragmentMask(uint8_t count) {
+    return count >= 32 ? 0xFFFFFFFFUL : (1UL << count) - 1;
+}
+
+// Reliable delivery
+
+void RealMeshRouter::sendAck(const MessagePacket& packet, uint32_t messageId) {
+    PacketHandle ack = RealMeshPacketPool::acquire(RealMeshPacket::createAckPacket(ownAddress, packet.source, messageId));
+    replyToSource(packet, ack);
+}
+
+void RealMeshRouter::sendNack(const MessagePacket& packet, uint32_t messageId, uint32_t missing) {
+    Serial.printf("[ROUTER] Message %u from %s missing %d fragments, sending NACK\n",
+                 messageId, packet.source.getFullAddress().c_str(), __builtin_popcount(missing));
+    
+    PacketHandle nack = RealMeshPacketPool::acquire(
+        RealMeshPacket::createNackPacket(ownAddress, packet.source, messageId, missing));
+    replyToSource(packet, nack);
+}
+
+void RealMeshRouter::replyToSource(const MessagePacket& packet, PacketHandle& reply) {
+    if (!reply) {
+        Serial.println("[ROUTER] Packet pool exhausted, reply not sent");
+        stats.messagesDropped++;
+        return;
+    }
+    
+    if (!routePacketDirect(reply)) {
+        reply->header.maxHops = packet.header.hopCount + 1;
+        routePacketFlood(reply);
+    }
+}
+
+void RealMeshRouter::trackDelivery(const PacketHandle& handle, uint8_t routingFlags) {
+    const MessagePacket& packet = *handle;
+    
+    if (outstandingMessages.size() >= RM_MAX_OUTSTANDING_MESSAGES) {
+        Serial.printf("[ROUTER] Delivery table full, message %u sent untracked\n", packet.header.messageId);
+        return;
+    }
+    
+    // Shares the caller's untouched slot; retries detach before routing
+    QueueEntry& entry = outstandingMessages[packet.header.messageId];
+    entry.packet = handle;
+    entry.queuedTime = millis();
+    entry.retryCount = 0;
+    entry.priority = (MessagePriority)packet.header.priority;
+    entry.nextRetryTime = entry.queuedTime + retryInterval(entry, routingFlags);
+    
+    if (deliveryCallback) {
+        deliveryCallback(packet.header.messageId, packet.destination, DELIVERY_PENDING);
+    }
+}
+
+uint32_t RealMeshRouter::retryInterval(const QueueEntry& entry, uint8_t routingFlags) {
+    // Wait out the ACK round trip, then back off 5s/15s/45s between retries
+    uint32_t interval = (routingFlags & ROUTE_FLOOD) ? RM_ACK_TIMEOUT_FLOOD : RM_ACK_TIMEOUT_DIRECT;
+    
+    if (entry.retryCount > 0) {
+        uint32_t backoff = RM_RETRY_INTERVAL_BASE;
+        for (uint8_t i = 1; i < entry.retryCount && backoff < RM_RETRY_INTERVAL_MAX; i++) {
+            backoff *= 3;
+        }
+        backoff = min((uint32_t)RM_RETRY_INTERVAL_MAX, backoff);
+        
+        // Jitter keeps senders that lost the same frame from retrying in lockstep
+        interval += backoff + random(backoff * RM_RETRY_JITTER_PERCENT / 100 + 1);
+    }
+    
+    return interval;
+}
+
+void RealMeshRouter::processOutstandingMessages() {
+    uint32_t now = millis();
+    
+    auto it = outstandingMessages.begin();
+    while (it != outstandingMessages.end()) {
+        QueueEntry& entry = it->second;
+        
+        if ((int32_t)(now - entry.nextRetryTime) < 0) {
+            ++it;
+            continue;
+        }
+        
+        AddressHandle destination = addresses.lookup(entry.packet->destination);
+        
+        // Still waiting for a route - the ACK clock hasn't really started
+        if (pendingDiscoveries.count(destination)) {
+            entry.nextRetryTime = now + RM_ACK_TIMEOUT_DIRECT;
+            ++it;
+            continue;
+        }
+        
+        // No ACK in time counts against the route we used
+        RoutingEntry* route = findRoute(destination);
+        if (route) {
+            updateRouteQuality(destination, route->signalStrength, false);
+        }
+        
+        if (entry.retryCount >= RM_MAX_RETRY_ATTEMPTS) {
+            Serial.printf("[ROUTER] Message %u to %s failed after %d retries\n",
+                         it->first, entry.packet->destination.getFullAddress().c_str(), entry.retryCount);
+            if (deliveryCallback) {
+                deliveryCallback(it->first, entry.packet->destination, DELIVERY_FAILED);
+            }
+            outgoingFragments.erase(it->first);
+            it = outstandingMessages.erase(it);
+            continue;
+        }
+        
+        entry.retryCount++;
+        Serial.printf("[ROUTER] Retrying message %u to %s (attempt %d)\n",
+                     it->first, entry.packet->destination.getFullAddress().c_str(), entry.retryCount + 1);
+        
+        // The count lets a retry that ends up flooded past relays that
+        // already passed on this messageId
+        PacketHandle packet = entry.packet;
+        if (packet.detach()) {
+            packet->header.routingFlags = (packet->header.routingFlags & ~ROUTE_RETRY_MASK) |
+                                          (entry.retryCount << RM_RETRY_SHIFT);
+        }
+        dispatchPacket(packet);
+        entry.nextRetryTime = now + retryInterval(entry, packet->header.routingFlags);
+        ++it;
+    }
+}
+
+// Managed flooding
+
+// Longest a frame the radio took can spend waiting for a clear channel
+static constexpr uint32_t channelWaitMs(uint8_t attempt = 1) {
+    return attempt >= RM_CAD_MAX_ATTEMPTS ? 0 :
+           ((uint32_t)RM_CAD_BACKOFF_SLOT_MS << (attempt < RM_CAD_BACKOFF_MAX_EXP ? attempt : RM_CAD_BACKOFF_MAX_EXP)) +
+           channelWaitMs(attempt + 1);
+}
+
+bool RealMeshRouter::scheduleRebroadcast(const PacketHandle& packet, float snr) {
+    if (pendingRebroadcasts.size() >= RM_MAX_PENDING_REBROADCASTS) {
+        // Neighbors are relaying too; dropping our copy is cheaper than colliding
+        stats.messagesDropped++;
+        return false;
+    }
+    
+    // Weak signal means we are far from the last sender and extend coverage
+    // the most, so we take an early slot. Strong-signal neighbors wait and
+    // usually get cancelled by overhearing us. A slot lasts as long as the
+    // frame on the control profile, so an earlier relay has finished by
+    // the time the next slot starts.
+    uint32_t delay = 0;
+    if (packet->header.priority != PRIORITY_EMERGENCY) {
+        NodeAddress broadcast = {};
+        uint32_t slotMs = RM_REBROADCAST_SLOT_MS + frameAirtime(broadcast, RealMeshPacket::serializedSize(*packet));
+        float position = (snr - RM_REBROADCAST_SNR_MIN) / (RM_REBROADCAST_SNR_MAX - RM_REBROADCAST_SNR_MIN);
+        position = constrain(position, 0.0f, 1.0f);
+        uint32_t slot = (uint32_t)(position * (RM_REBROADCAST_SLOTS - 1) + 0.5f);
+        delay = slot * slotMs;
+    }
+    delay += random(RM_REBROADCAST_JITTER_MS);
+    
+    PendingRebroadcast pending;
+    pending.packet = packet;
+    pending.sendTime = millis() + delay;
+    pending.copiesHeard = 0;
+    pending.stage = REBROADCAST_WAITING;
+    pendingRebroadcasts.push_back(pending);
+    return true;
+}
+
+void RealMeshRouter::noteOverheardCopy(uint16_t sourceId, uint32_t messageId) {
+    for (auto it = pendingRebroadcasts.begin(); it != pendingRebroadcasts.end(); ++it) {
+        if (it->packet->header.messageId != messageId ||
+            it->packet->source.uuid.getShortId() != sourceId) {
+            continue;
+        }
+        
+        // Enough neighbors already covered this area - stay quiet
+        if (++it->copiesHeard < RM_REBROADCAST_COPIES) {
+            return;
+        }
+        
+        bool cancelled = true;
+        if (it->stage == REBROADCAST_QUEUED) {
+            const MessagePacket* slot = &*it->packet;
+            std::vector<const QueueEntry*> queued;
+            txQueue.forEach([&](const QueueEntry& entry) {
+                if (&*entry.packet == slot) {
+                    queued.push_back(&entry);
+                }
+            });
+            txQueue.remove(queued);
+        } else if (it->stage == REBROADCAST_SENDING) {
+            cancelled = cancelSendCallback && cancelSendCallback(sourceId, messageId);
+        }
+        
+        if (cancelled) {
+            if (it->stage != REBROADCAST_WAITING) {
+                stats.messagesForwarded--; // Counted when queued, never went out
+            }
+            stats.messagesDropped++;
+        }
+        pendingRebroadcasts.erase(it);
+        return;
+    }
+}
+
+void RealMeshRouter::processRebroadcasts() {
+    uint32_t now = millis();
+    
+    for (size_t i = 0; i < pendingRebroadcasts.size(); ) {
+        PendingRebroadcast& pending = pendingRebroadcasts[i];
+        
+        switch (pending.stage) {
+            case REBROADCAST_WAITING:
+                if ((int32_t)(now - pending.sendTime) < 0) {
+                    break;
+                }
+                if (!enqueuePacket(pending.packet)) {
+                    pendingRebroadcasts.erase(pendingRebroadcasts.begin() + i);
+                    continue;
+                }
+                stats.messagesForwarded++;
+                pending.stage = REBROADCAST_QUEUED;
+                break;
+                
+            case REBROADCAST_QUEUED:
+                // Only the queue shared the slot; once it lets go the radio
+                // has the frame (or the queue dropped it)
+                if (!pending.packet.isShared()) {
+                    pending.stage = REBROADCAST_SENDING;
+                    pending.sendTime = now;
+                }
+                break;
+                
+            case REBROADCAST_SENDING:
+                if (now - pending.sendTime > channelWaitMs()) {
+                    pendingRebroadcasts.erase(pendingRebroadcasts.begin() + i);
+                    continue;
+                }
+                break;
+        }
+        i++;
+    }
+}
+
+// Route discovery
+
+bool RealMeshRouter::bufferForDiscovery(const PacketHandle& handle) {
+    const MessagePacket& packet = *handle;
+    AddressHandle destination = internAddress(packet.destination);
+    if (destination == RM_INVALID_ADDRESS) {
+        return false;
+    }
+    
+    // Coalesce with a discovery already in flight for this destination
+    auto it = pendingDiscoveries.find(destination);
+    if (it != pendingDiscoveries.end()) {
+        for (const PacketHandle& waiting : it->second.buffered) {
+            if (waiting->header.messageId == packet.header.messageId) {
+                return true; // Retry of a message still waiting for the route
+            }
+        }
+        if (it->second.buffered.size() >= RM_DISCOVERY_BUFFER_SIZE) {
+            return false;
+        }
+        it->second.buffered.push_back(handle);
+        Serial.printf("[ROUTER] Route discovery for %s pending, buffered message (%d waiting)\n",
+                     addresses.nameOf(destination).c_str(), it->second.buffered.size());
+        return true;
+    }
+    
+    // Held until the route is known; routing it later detaches the slot
+    // if a retry entry still shares it
+    if (pendingDiscoveries.size() >= RM_MAX_PENDING_DISCOVERIES) {
+        return false;
+    }
+    
+    pendingDiscoveries[destination].buffered.push_back(handle);
+    initiateRouteDiscovery(packet.destination);
+    return true;
+}
+
+void RealMeshRouter::initiateRouteDiscovery(const NodeAddress& destination) {
+    AddressHandle handle = addresses.lookup(destination);
+    if (handle == RM_INVALID_ADDRESS) {
+        return;
+    }
+    
+    PendingDiscovery& pending = pendingDiscoveries[handle];
+    pending.attempts = 0;
+    sendRouteRequest(handle, pending);
+}
+
+void RealMeshRouter::sendRouteRequest(AddressHandle destination, PendingDiscovery& pending) {
+    // Expanding ring: look nearby first, then across the whole mesh
+    uint8_t maxHops = pending.attempts == 0 ? RM_ROUTE_DISCOVERY_RING : RM_MAX_HOP_COUNT;
+    
+    MessagePacket request = RealMeshPacket::createRouteRequestPacket(ownAddress, addresses.get(destination), maxHops);
+    addToPathHistory(request);
+    
+    pending.requestId = request.header.messageId;
+    pending.requestTime = millis();
+    pending.attempts++;
+    
+    Serial.printf("[ROUTER] Route request for %s (attempt %d, max hops: %d)\n",
+                 addresses.nameOf(destination).c_str(), pending.attempts, maxHops);
+    
+    if (enqueuePacket(request)) {
+        stats.messagesSent++;
+    }
+}
+
+void RealMeshRouter::handleRouteRequest(const MessagePacket& packet) {
+    Serial.printf("[ROUTER] Route request from %s for us\n", packet.source.getFullAddress().c_str());
+    
+    RouteReplyData reply = {packet.header.messageId, 0, ownAddress};
+    sendRouteReply(packet, reply);
+}
+
+void RealMeshRouter::handleRouteReply(const MessagePacket& packet) {
+    RouteReplyData reply;
+    if (!RealMeshPacket::parseRouteReply(packet, reply)) {
+        Serial.println("[ROUTER] Malformed route reply");
+        return;
+    }
+    
+    Serial.printf("[ROUTER] Route reply from %s: %s is %d hop(s) beyond it\n",
+                 packet.source.getFullAddress().c_str(),
+                 reply.target.getFullAddress().c_str(),
+                 reply.hopCount);
+    
+    completeRouteDiscovery(addresses.lookup(reply.target));
+}
+
+bool RealMeshRouter::answerRouteRequest(const MessagePacket& packet) {
+    AddressHandle target = addresses.lookup(packet.destination);
+    if (target == RM_INVALID_ADDRESS) {
+        return false;
+    }
+    
+    // Only vouch for fresh, healthy routes
+    RoutingEntry* route = findRoute(target);
+    if (!route || route->reliability < RM_ROUTE_REPLY_MIN_RELIABILITY || (millis() - route->lastUsed) > RM_ROUTE_STALE_MS) {
+        return false;
+    }
+    
+    // A route leading back toward the requester would just create a loop
+    AddressHandle requester = addresses.lookup(packet.source);
+    AddressHandle relay = addresses.findByShortId(packet.header.pathHistory[0]);
+    if (route->nextHop == requester || route->nextHop == relay) {
+        return false;
+    }
+    
+    RouteReplyData reply = {packet.header.messageId, (uint8_t)route->hopCount, addresses.get(target)};
+    sendRouteReply(packet, reply);
+    return true;
+}
+
+void RealMeshRouter::sendRouteReply(const MessagePacket& request, const RouteReplyData& reply) {
+    PacketHandle packet = RealMeshPacketPool::acquire(
+        RealMeshPacket::createRouteReplyPacket(ownAddress, request.source, reply));
+    
+    // The request just taught us the reverse path; flood only if it couldn't be decoded
+    replyToSource(request, packet);
+}
+
+void RealMeshRouter::learnFromRouteReply(const MessagePacket& packet, int16_t rssi) {
+    RouteReplyData reply;
+    if (!RealMeshPacket::parseRouteReply(packet, reply) || reply.hopCount == 0) {
+        return; // Target answered itself - path learning already covered it
+    }
+    
+    AddressHandle target = internAddress(reply.target);
+    AddressHandle replier = addresses.lookup(packet.source);
+    if (target == RM_INVALID_ADDRESS || target == ownHandle || target == replier) {
+        return;
+    }
+    
+    // The target lies beyond the replier, along our route to the replier
+    RoutingEntry* viaReplier = findRoute(replier);
+    if (viaReplier) {
+        learnRoute(target, viaReplier->nextHop, viaReplier->hopCount + reply.hopCount, rssi);
+    }
+}
+
+void RealMeshRouter::completeRouteDiscovery(AddressHandle destination) {
+    auto it = pendingDiscoveries.find(destination);
+    if (it == pendingDiscoveries.end() || !findRoute(destination)) {
+        return;
+    }
+    
+    std::vector<PacketHandle> buffered = std::move(it->second.buffered);
+    Serial.printf("[ROUTER] Route to %s discovered after %d request(s), sending %d buffered\n",
+                 addresses.nameOf(destination).c_str(), it->second.attempts, buffered.size());
+    pendingDiscoveries.erase(it);
+    
+    for (PacketHandle& packet : buffered) {
+        if (!routePacketDirect(packet)) {
+            routePacketFlood(packet);
+        }
+    }
+}
+
+void RealMeshRouter::processRouteDiscoveries() {
+    uint32_t now = millis();
+    
+    auto it = pendingDiscoveries.begin();
+    while (it != pendingDiscoveries.end()) {
+        AddressHandle destination = it->first;
+        PendingDiscovery& pending = it->second;
+        ++it; // Completing or giving up erases the current entry
+        
+        // Route may have been learned from other traffic meanwhile
+        if (findRoute(destination)) {
+            completeRouteDiscovery(destination);
+            continue;
+        }
+        
+        // Each retry waits twice as long as the previous one
+        uint32_t timeout = (uint32_t)RM_ROUTE_DISCOVERY_TIMEOUT << (pending.attempts > 0 ? pending.attempts - 1 : 0);
+        if (now - pending.requestTime < timeout) {
+            continue;
+        }
+        
+        if (pending.attempts <= RM_ROUTE_DISCOVERY_RETRIES) {
+            sendRouteRequest(destination, pending);
+            continue;
+        }
+        
+        // Nobody knows the way - fall back to flooding what we were holding
+        Serial.printf("[ROUTER] Route discovery for %s failed, flooding %d message(s)\n",
+                     addresses.nameOf(destination).c_str(), pending.buffered.size());
+        std::vector<PacketHandle> buffered = std::move(pending.buffered);
+        pendingDiscoveries.erase(destination);
+        
+        for (PacketHandle& packet : buffered) {
+            routePacketFlood(packet);
+        }
+    }
+}
+
+bool RealMeshRouter::isDuplicatePacket(uint16_t sourceId, uint32_t messageId, uint8_t retry) {
+    uint32_t hash = seenMessageHash(sourceId, messageId);
+    
+    // Filter slot is empty - definitely not seen, skip the ring scan
+    if (seenFilter[hash & (RM_SEEN_FILTER_SIZE - 1)] == 0) {
+        return false;
+    }
+    
+    uint32_t now = millis();
+    for (uint16_t i = 0; i < seenCacheCount; i++) {
+        const SeenMessageEntry& entry = seenCache[i];
+        if (entry.hash == hash &&
+            entry.messageId == messageId &&
+            entry.sourceId == sourceId &&
+            entry.retry >= retry &&
+            (now - entry.seenTime) < RM_MESSAGE_MAX_AGE) {
+            return true;
+        }
+    }
+    
+    return false;
+}
+
+void RealMeshRouter::rememberPacket(uint16_t sourceId, uint32_t messageId, uint8_t retry) {
+    uint32_t hash = seenMessageHash(sourceId, messageId);
+    SeenMessageEntry& slot = seenCache[seenCacheHead];
+    
+    // Evict the oldest entry once the ring is full
+    if (seenCacheCount == RM_SEEN_CACHE_SIZE) {
+        uint8_t& counter = seenFilter[slot.hash & (RM_SEEN_FILTER_SIZE - 1)];
+        if (counter > 0) counter--;
+    } else {
+        seenCacheCount++;
+    }
+    
+    slot.sourceId = sourceId;
+    slot.messageId = messageId;
+    slot.hash = hash;
+    slot.seenTime = millis();
+    slot.retry = retry;
+    
+    uint8_t& counter = seenFilter[hash & (RM_SEEN_FILTER_SIZE - 1)];
+    if (counter < 255) counter++;
+    
+    seenCacheHead = (seenCacheHead + 1) % RM_SEEN_CACHE_SIZE;
+}
+
+uint32_t RealMeshRouter::seenMessageHash(uint16_t sourceId, uint32_t messageId) {
+    // FNV-1a over the short ID followed by the message ID
+    uint32_t hash = 2166136261u;
+    hash = (hash ^ (sourceId & 0xFF)) * 16777619u;
+    hash = (hash ^ (sourceId >> 8)) * 16777619u;
+    for (int i = 0; i < 4; i++) {
+        hash = (hash ^ ((messageId >> (i * 8)) & 0xFF)) * 16777619u;
+    }
+    return hash;
+}
+
+std::vector<AddressHandle> RealMeshRouter::findSubdomainHelpers(const String& targetSubdomain) {
+    std::vector<AddressHandle> helpers;
+    
+    if (subdomains.find(targetSubdomain) != subdomains.end()) {
+        const SubdomainInfo& info = subdomains[targetSubdomain];
+        for (AddressHandle hub : info.stationaryHubs) {
+            if (findRoute(hub) != nullptr) {
+                helpers.push_back(hub);
+            }
+        }
+    }
+    
+    return helpers;
+}
+
+void RealMeshRouter::addStationaryHub(const NodeAddress& hub) {
+    addStationaryHub(internAddress(hub));
+}
+
+void RealMeshRouter::addStationaryHub(AddressHandle hub) {
+    if (hub == RM_INVALID_ADDRESS) {
+        return;
+    }
+    
+    const NodeAddress& hubAddress = addresses.get(hub);
+    SubdomainInfo& info = subdomains[hubAddress.subdomain];
+    
+    // Check if already in the list
+    if (std::find(info.stationaryHubs.begin(), info.stationaryHubs.end(), hub) != info.stationaryHubs.end()) {
+        return;
+    }
+    
+    info.stationaryHubs.push_back(hub);
+    Serial.printf("[ROUTER] Added stationary hub: %s for subdomain %s\n",
+                 addresses.nameOf(hub).c_str(),
+                 hubAddress.subdomain.c_str());
+}
+
+bool RealMeshRouter::resolveNode(uint32_t hash, uint16_t shortId, NodeAddress& address) const {
+    AddressHandle handle = addresses.findByHash(hash);
+    if (handle == RM_INVALID_ADDRESS) {
+        return false;
+    }
+    
+    // A short ID that disagrees means a different node with the same hash
+    uint16_t knownShortId = addresses.shortIdOf(handle);
+    if (shortId != 0 && knownShortId != 0 && knownShortId != shortId) {
+        return false;
+    }
+    
+    address = addresses.get(handle);
+    return true;
+}
+
+bool RealMeshRouter::resolveSubdomain(uint16_t hash, String& subdomain) const {
+    for (const auto& pair : subdomains) {
+        if (RealMeshPacket::subdomainHash(pair.first) == hash) {
+            subdomain = pair.first;
+            return true;
+        }
+    }
+    return false;
+}
+
+AddressHandle RealMeshRouter::internAddress(const NodeAddress& address) {
+    if (!address.isValid()) {
+        return RM_INVALID_ADDRESS;
+    }
+    
+    AddressHandle handle = addresses.intern(address);
+    if (handle == RM_INVALID_ADDRESS) {
+        // Table full - reclaim addresses no table refers to any more
+        collectAddresses();
+        handle = addresses.intern(address);
+    }
+    
+    return handle;
+}
+
+void RealMeshRouter::collectAddresses() {
+    addresses.beginCollection();
+    addresses.mark(ownHandle);
+    
+    for (size_t i = 0; i < routingTable.size(); i++) {
+        const RoutingEntry& entry = routingTable.at(i);
+        addresses.mark(entry.destination);
+        for (uint8_t c = 0; c < entry.candidateCount; c++) {
+            addresses.mark(entry.candidates[c].nextHop);
+        }
+    }
+    
+    for (const auto& pair : subdomains) {
+        for (AddressHandle node : pair.second.knownNodes) addresses.mark(node);
+        for (AddressHandle hub : pair.second.stationaryHubs) addresses.mark(hub);
+    }
+    
+    for (const auto& entry : intermediaryMemory) {
+        addresses.mark(entry.nodeA);
+        addresses.mark(entry.nodeB);
+    }
+    
+    for (const auto& pair : pendingDiscoveries) {
+        addresses.mark(pair.first);
+    }
+    
+    for (const auto& pair : nodeHeartbeats) {
+        addresses.mark(pair.first);
+    }
+    
+    for (const auto& pair : reassemblyBuffers) {
+        addresses.mark(pair.second.source);
+    }
+    
+    size_t freed = addresses.sweep();
+    Serial.printf("[ROUTER] Address table collected %d entries (%d in use)\n",
+                 freed, addresses.size());
+}
+
+bool RealMeshRouter::isValidPacket(const MessagePacket& packet) {
+    return packet.source.isValid() && 
+           (packet.header.protocolVersion == RM_PROTOCOL_V1 || packet.header.protocolVersion == RM_PROTOCOL_V2) &&
+           packet.header.payloadLength <= RM_MAX_PAYLOAD_SIZE;
+}
+
+bool RealMeshRouter::isPacketForUs(const MessagePacket& packet) {
+    // Check if destination matches our address
+    if (packet.destination.sameAddress(ownAddress)) {
+        return true;
+    }
+    
+    // Check if it's a broadcast (empty destination)
+    if (packet.destination.nodeId.isEmpty() && packet.destination.subdomain.isEmpty()) {
+        return true;
+    }
+    
+    // Check if it's a subdomain broadcast for our subdomain
+    if (packet.destination.nodeId.isEmpty() && packet.destination.subdomain == ownAddress.subdomain) {
+        return true;
+    }
+    
+    return false;
+}
+
+void RealMeshRouter::addToPathHistory(MessagePacket& packet) {
+    // Shift path history and add ourselves
+    for (int i = RM_PATH_HISTORY_SIZE - 1; i > 0; i--) {
+        packet.header.pathHistory[i] = packet.header.pathHistory[i-1];
+    }
+    
+    // Add our short ID so downstream nodes can name us as their next hop
+    packet.header.pathHistory[0] = ownAddress.uuid.getShortId();
+}
+
+bool RealMeshRouter::isInPathHistory(const MessagePacket& packet, const NodeAddress& address) {
+    uint16_t nodeId = address.uuid.getShortId();
+    
+    for (int i = 0; i < RM_PATH_HISTORY_SIZE; i++) {
+        if (packet.header.pathHistory[i] == nodeId) {
+            return true;
+        }
+    }
+    
+    return false;
+}
+
+float RealMeshRouter::linkEtx(AddressHandle neighbor) const {
+    if (neighbor == RM_INVALID_ADDRESS) return RM_NEIGHBOR_MAX_ETX;
+    return neighbors.getEtx(addresses.shortIdOf(neighbor));
+}
+
+bool RealMeshRouter::isRouteExpired(const RoutingEntry& entry) {
+    // Routes expire after 1 hour of non-use for mobile nodes
+    // Stationary routes expire after 24 hours
+    uint32_t expireTime = (ownStatus == NODE_STATIONARY) ? 86400000 : 3600000;
+    return (millis() - entry.lastUsed) > expireTime;
+}
+
+void RealMeshRouter::printRoutingTable() {
+    Serial.printf("[ROUTER] Routing Table (%d entries):\n", routingTable.size());
+    for (size_t i = 0; i < routingTable.size(); i++) {
+        const RoutingEntry& entry = routingTable.at(i);
+        for (uint8_t c = 0; c < entry.candidateCount; c++) {
+            const RouteCandidate& candidate = entry.candidates[c];
+            Serial.printf("  %s %s %s (hops: %d, rel: %d%%, rssi: %ddBm, link etx: %.2f, cost: %.2f)\n",
+                         c == 0 ? addresses.nameOf(entry.destination).c_str() : "",
+                         c == 0 ? "->" : "  alt",
+                         addresses.nameOf(candidate.nextHop).c_str(),
+                         candidate.hopCount,
+                         candidate.reliability,
+                         candidate.signalStrength,
+                         linkEtx(candidate.nextHop),
+                         routeCost(candidate));
+        }
+    }
+}
+
+void RealMeshRouter::setRoutePreference(const NodeAddress& destination, const NodeAddress& nextHop, uint8_t preference) {
+    AddressHandle destinationHandle = internAddress(destination);
+    RouteCandidate* candidate = addRouteCandidate(destinationHandle, internAddress(nextHop));
+    if (!candidate) {
+        return;
+    }
+    
+    candidate->preference = preference;
+    rankRouteCandidates(*routingTable.find(destinationHandle));
+}
+
+void RealMeshRouter::printHeartbeats() {
+    Serial.printf("[ROUTER] Heartbeats (%d nodes):\n", nodeHeartbeats.size());
+    for (const auto& pair : nodeHeartbeats) {
+        const HeartbeatSummary& hb = pair.second;
+        Serial.printf("  %s: status %d, up %us, contacts %d, bridges %d, sent %u, recv %u, rssi %d, load %d%%, heard %us ago\n",
+                     addresses.nameOf(pair.first).c_str(), hb.status, hb.uptimeSeconds,
+                     hb.directContacts, hb.bridgedSubdomains, hb.messagesSent, hb.messagesReceived,
+                     hb.avgRSSI, hb.networkLoad, (unsigned)((millis() - hb.lastHeard) / 1000));
+    }
+}
+
+void RealMeshRouter::printSubdomainInfo() {
+    Serial.printf("[ROUTER] Subdomain Information (%d subdomains):\n", subdomains.size());
+    for (const auto& pair : subdomains) {
+        const SubdomainInfo& info = pair.second;
+        Serial.printf("  %s: %d nodes, %d hubs, %s\n",
+                     info.subdomainName.c_str(),
+                     info.knownNodes.size(),
+                     info.stationaryHubs.size(),
+                     info.isLocal ? "LOCAL" : "REMOTE");
     }
 }
 
@@ -576,8 +2107,8 @@ void RealMeshRouter::printIntermediaryMemory() {
     for (const auto& entry : intermediaryMemory) {
         if (entry.isActive) {
             Serial.printf("  %s <-> %s (bridges: %d)\n",
-                         entry.nodeA.getFullAddress().c_str(),
-                         entry.nodeB.getFullAddress().c_str(),
+                         addresses.nameOf(entry.nodeA).c_str(),
+                         addresses.nameOf(entry.nodeB).c_str(),
                          entry.bridgeCount);
         }
     }
@@ -593,6 +2124,10 @@ void RealMeshRouter::printNetworkStats() {
     Serial.printf("Average RSSI: %.1f dBm\n", stats.avgRSSI);
     Serial.printf("Network Load: %d%%\n", stats.networkLoad);
     Serial.printf("Last Heartbeat: %d ms ago\n", millis() - stats.lastHeartbeat);
+    Serial.printf("Heartbeat Interval: %u s (%d suppressed)\n", heartbeatInterval / 1000, stats.heartbeatsSuppressed);
+    Serial.printf("Frames Aggregated: %d\n", stats.framesAggregated);
+    Serial.printf("Packet Pool: %d/%d free (%u exhausted)\n", RealMeshPacketPool::available(),
+                 RealMeshPacketPool::capacity(), RealMeshPacketPool::getExhausted());
 }
 
 // Missing method implementations
@@ -627,16 +2162,26 @@ bool RealMeshRouter::handleHeartbeatMessage(const MessagePacket& packet, int16_t
     Serial.printf("[ROUTER] Heartbeat from %s (RSSI: %d)\n", 
                   packet.source.getFullAddress().c_str(), rssi);
     
-    // Update node information and routing tables
-    NodeAddress source = packet.source;
+    // Route to the sender was already learned in updatePathFromPacket
+    // (direct or via the relay that delivered this heartbeat)
     
-    // Add or update routing entry for direct neighbor
-    addRoute(source, source, 1);
+    HeartbeatSummary heartbeat;
+    if (!RealMeshPacket::parseHeartbeat(packet, heartbeat)) {
+        Serial.println("[ROUTER] Unreadable heartbeat payload");
+        return false;
+    }
     
-    // Parse heartbeat payload for additional network info
-    // (battery level, node type, neighboring nodes, etc.)
+    AddressHandle source = internAddress(packet.source);
+    if (source == RM_INVALID_ADDRESS) {
+        return false;
+    }
     
-    Serial.println("[ROUTER] Heartbeat processed");
+    rememberHeartbeat(source, heartbeat);
+    if ((heartbeat.fields & HB_FIELD_STATUS) && heartbeat.status == NODE_STATIONARY) {
+        addStationaryHub(source);
+    }
+    
+    Serial.printf("[ROUTER] Heartbeat processed (fields: 0x%02X)\n", heartbeat.fields);
     return true;
 }
 
@@ -644,13 +2189,173 @@ bool RealMeshRouter::handleAckMessage(const MessagePacket& packet, int16_t rssi)
     Serial.printf("[ROUTER] ACK message from %s (RSSI: %d)\n", 
                   packet.source.getFullAddress().c_str(), rssi);
     
-    // Process acknowledgments:
-    // 1. Mark messages as successfully delivered
-    // 2. Update reliability statistics
-    // 3. Clear retry queues
+    if (packet.header.messageType != MSG_ACK || packet.header.payloadLength < sizeof(uint32_t)) {
+        return false;
+    }
     
     // Extract message ID from payload and mark as acknowledged
-    uint32_t ackedMessageId = packet.header.messageId;
-    Serial.printf("[ROUTER] Message %u acknowledged\n", ackedMessageId);
+    uint32_t ackedMessageId;
+    memcpy(&ackedMessageId, packet.payload, sizeof(uint32_t));
+    outgoingFragments.erase(ackedMessageId);
+    
+    auto it = outstandingMessages.find(ackedMessageId);
+    if (it == outstandingMessages.end()) {
+        return false; // Late ACK for a retry we already gave up on, or a repeat
+    }
+    
+    // Reward the route that carried it; only a first-attempt round trip
+    // says anything about the path's latency
+    AddressHandle destination = addresses.lookup(it->second.packet->destination);
+    RoutingEntry* route = findRoute(destination);
+    if (route) {
+        if (it->second.retryCount == 0) {
+            recordRouteLatency(destination, millis() - it->second.queuedTime);
+        }
+        updateRouteQuality(destination, route->signalStrength, true);
+    }
+    
+    Serial.printf("[ROUTER] Message %u acknowledged after %u ms (%d retries)\n",
+                 ackedMessageId, (unsigned)(millis() - it->second.queuedTime), it->second.retryCount);
+    
+    if (deliveryCallback) {
+        deliveryCallback(ackedMessageId, it->second.packet->destination, DELIVERY_ACKED);
+    }
+    outstandingMessages.erase(it);
+    return true;
+}
+
+bool RealMeshRouter::handleNackMessage(const MessagePacket& packet, int16_t rssi) {
+    uint32_t messageId;
+    uint32_t missing;
+    if (!RealMeshPacket::parseNack(packet, messageId, missing)) {
+        return false;
+    }
+    
+    auto it = outgoingFragments.find(messageId);
+    if (it == outgoingFragments.end()) {
+        return false; // Already ACKed or given up on
+    }
+    
+    // Only a receiver holding the last fragment sends a NACK; resend the rest
+    FragmentedMessage& outgoing = it->second;
+    missing &= fragmentMask(outgoing.count - 1);
+    outgoing.pending |= missing;
+    
+    Serial.printf("[ROUTER] NACK from %s: resending %d of %d fragments of message %u\n",
+                 packet.source.getFullAddress().c_str(), __builtin_popcount(missing), outgoing.count, messageId);
+    
+    // Give the resent fragments time to arrive before probing again
+    auto tracked = outstandingMessages.find(messageId);
+    if (tracked != outstandingMessages.end()) {
+        tracked->second.nextRetryTime = millis() + retryInterval(tracked->second, ROUTE_DIRECT);
+    }
+    
+    processFragments();
     return true;
-}
\ No newline at end of file
+}
+
+bool RealMeshRouter::handleFragmentMessage(const MessagePacket& packet) {
+    FragmentData fragment;
+    if (!RealMeshPacket::parseFragment(packet, fragment)) {
+        Serial.println("[ROUTER] Unreadable fragment");
+        return false;
+    }
+    
+    AddressHandle source = internAddress(packet.source);
+    if (source == RM_INVALID_ADDRESS) {
+        return false;
+    }
+    
+    uint64_t key = ((uint64_t)source << 32) | fragment.messageId;
+    auto it = reassemblyBuffers.find(key);
+    if (it == reassemblyBuffers.end()) {
+        ReassemblyBuffer& fresh = reassemblyBuffers[key];
+        fresh.source = source;
+        fresh.messageId = fragment.messageId;
+        fresh.count = fragment.count;
+        fresh.received = 0;
+        fresh.compressed = (packet.header.routingFlags & ROUTE_COMPRESSED) != 0;
+        fresh.lastUpdate = millis();
+        fresh.complete = false;
+        
+        // All fragments but the last are the same size, so any one of them
+        // tells us roughly how long the message is
+        size_t expected = fragment.index == fragment.count - 1 ?
+                          fragment.offset + fragment.length : (size_t)fragment.count * fragment.length;
+        if (!reserveReassembly(fresh, std::min(expected, (size_t)RM_FRAGMENT_MAX_MESSAGE))) {
+            Serial.println("[ROUTER] Reassembly memory full, fragment dropped");
+            reassemblyBuffers.erase(key);
+            return false;
+        }
+        it = reassemblyBuffers.find(key);
+    }
+    
+    ReassemblyBuffer& buffer = it->second;
+    if (fragment.count != buffer.count) {
+        return false;
+    }
+    
+    uint32_t bit = 1UL << fragment.index;
+    if (!buffer.complete && !(buffer.received & bit)) {
+        size_t end = fragment.offset + fragment.length;
+        if (end > buffer.data.capacity() && !reserveReassembly(buffer, end)) {
+            Serial.printf("[ROUTER] Reassembly memory full, fragment %d/%d of message %u dropped\n",
+                         fragment.index + 1, fragment.count, fragment.messageId);
+            return false;
+        }
+        
+        if (end > buffer.data.size()) {
+            buffer.data.resize(end);
+        }
+        memcpy(buffer.data.data() + fragment.offset, fragment.data, fragment.length);
+        buffer.received |= bit;
+        buffer.lastUpdate = millis();
+    }
+    
+    // Broadcast fragments are never acknowledged
+    bool direct = packet.destination.sameAddress(ownAddress);
+    
+    if (!buffer.complete && buffer.received == fragmentMask(buffer.count)) {
+        buffer.complete = true;
+        Serial.printf("[ROUTER] Reassembled %d byte message %u from %s\n",
+                     buffer.data.size(), buffer.messageId, packet.source.getFullAddress().c_str());
+        
+        if (buffer.compressed) {
+            std::vector<uint8_t> text(RM_FRAGMENT_MAX_MESSAGE);
+            size_t length = RealMeshCompression::decompress(buffer.data.data(), buffer.data.size(),
+                                                            text.data(), text.size());
+            if (length == 0) {
+                // Not delivered, so not acknowledged; the sender's retries
+                // run out and it reports the message as failed
+                Serial.printf("[ROUTER] Message %u from %s failed to decompress, dropped\n",
+                             buffer.messageId, packet.source.getFullAddress().c_str());
+                reassemblyBuffers.erase(it);
+                return false;
+            }
+            text.resize(length);
+            buffer.data.swap(text);
+        }
+        
+        if (reassembledCallback && !buffer.data.empty()) {
+            reassembledCallback(packet.source, String((const char*)buffer.data.data(), buffer.data.size()));
+        }
+        std::vector<uint8_t>().swap(buffer.data); // Keep only the record, for re-ACKs
+        
+        if (direct) {
+            sendAck(packet, fragment.messageId);
+        }
+        return false;
+    }
+    
+    // The last fragment ends a burst, or is the sender probing after an ACK
+    // timeout: answer with what is still missing
+    if (direct && fragment.index == fragment.count - 1) {
+        if (buffer.complete) {
+            sendAck(packet, fragment.messageId);
+        } else {
+            sendNack(packet, fragment.messageId, fragmentMask(buffer.count) & ~buffer.received);
+        }
+    }
+    
+    return false; // Don't forward - fragment was for us
+}
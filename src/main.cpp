@@ -182,6 +182,13 @@ void setup() {
     }
   });
   
+  // Push delivery confirmations for direct messages to the mobile app
+  meshNode->setOnDeliveryStatus([](uint32_t messageId, const String& to, DeliveryStatus status) {
+    if (mobileAPI) {
+      mobileAPI->notifyDeliveryStatus(messageId, to, status);
+    }
+  });
+  
   // Start BLE for mobile API by default
   // Use node's address if set, otherwise use last 4 characters of MAC address
   String deviceName;